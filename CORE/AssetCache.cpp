@@ -0,0 +1,171 @@
+#include "AssetCache.h"
+
+#include <algorithm>
+#include <filesystem>
+
+// Бюджеты по умолчанию (меняются ключом --asset-cache-mb)
+static const size_t kDefaultModelBudget = 256ull * 1024 * 1024;
+static const size_t kDefaultCollisionBudget = 32ull * 1024 * 1024;
+
+LruAssetCache<dff::DffModel>& AssetCache::Models() {
+    static LruAssetCache<dff::DffModel> cache(kDefaultModelBudget);
+    return cache;
+}
+
+LruAssetCache<std::vector<CollisionModel>>& AssetCache::Collisions() {
+    static LruAssetCache<std::vector<CollisionModel>> cache(kDefaultCollisionBudget);
+    return cache;
+}
+
+UnpackIndex& AssetCache::Unpack() {
+    static UnpackIndex index("unpack");
+    return index;
+}
+
+static std::string toLowerName(std::string_view name) {
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
+void UnpackIndex::ScanLocked() {
+    m_scanned = true;
+
+    std::error_code error;
+    std::filesystem::directory_iterator it(m_directory, error);
+    if (error) {
+        return;
+    }
+    for (const auto& entry : it) {
+        if (!entry.is_regular_file(error)) {
+            continue;
+        }
+        const std::filesystem::path& path = entry.path();
+        if (toLowerName(path.extension().string()) != ".dff") {
+            continue;
+        }
+        m_files.emplace(toLowerName(path.stem().string()), m_directory + "\\" + path.filename().string());
+    }
+}
+
+std::string UnpackIndex::FindModel(std::string_view modelName) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_scanned) {
+        ScanLocked();
+    }
+
+    auto it = m_files.find(toLowerName(modelName));
+    return it != m_files.end() ? it->second : std::string();
+}
+
+void UnpackIndex::MarkMissing(std::string_view modelName) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_missing.insert(toLowerName(modelName));
+}
+
+bool UnpackIndex::IsMissing(std::string_view modelName) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_missing.find(toLowerName(modelName)) != m_missing.end();
+}
+
+size_t UnpackIndex::GetFileCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_scanned) {
+        ScanLocked();
+    }
+    return m_files.size();
+}
+
+uint64_t AssetCache::MakeFileKey(const std::string& path) {
+    // Пути интернируются: один и тот же файл всегда получает один номер
+    static std::mutex internMutex;
+    static std::map<std::string, uint32_t> internedPaths;
+
+    std::string normalized = path;
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(), ::tolower);
+    std::replace(normalized.begin(), normalized.end(), '/', '\\');
+
+    std::lock_guard<std::mutex> lock(internMutex);
+    auto it = internedPaths.find(normalized);
+    if (it == internedPaths.end()) {
+        it = internedPaths.emplace(normalized, static_cast<uint32_t>(internedPaths.size())).first;
+    }
+    return MakeKey(kDiskArchive, it->second);
+}
+
+size_t AssetCache::EstimateBytes(const dff::DffModel& model) {
+    return sizeof(dff::DffModel) + model.name.capacity() +
+           model.vertices.capacity() * sizeof(dff::Vertex) +
+           model.normals.capacity() * sizeof(dff::Normal) +
+           model.uvCoords.capacity() * sizeof(dff::UVCoord) +
+           model.vertexColors.capacity() * sizeof(dff::VertexColor) +
+           model.polygons.capacity() * sizeof(dff::Polygon) +
+           model.materials.capacity() * sizeof(dff::Material) +
+           model.geometryRanges.capacity() * sizeof(dff::GeometryRange) +
+           model.gpuVertices.capacity() * sizeof(dff::GpuVertex) +
+           model.gpuIndices.capacity();
+}
+
+size_t AssetCache::EstimateBytes(const std::vector<CollisionModel>& models) {
+    size_t bytes = sizeof(models) + models.capacity() * sizeof(CollisionModel);
+    for (const auto& model : models) {
+        bytes += model.name.capacity() +
+                 model.spheres.capacity() * sizeof(CollisionSphere) +
+                 model.boxes.capacity() * sizeof(CollisionBox) +
+                 model.vertices.capacity() * sizeof(CollisionVertex) +
+                 model.faces.capacity() * sizeof(CollisionFace) +
+                 model.shadowVertices.capacity() * sizeof(CollisionVertex) +
+                 model.shadowFaces.capacity() * sizeof(ShadowFace);
+    }
+    return bytes;
+}
+
+std::shared_ptr<const dff::DffModel> AssetCache::LoadDffFile(const std::string& path) {
+    const uint64_t key = MakeFileKey(path);
+    if (auto cached = Models().Find(key)) {
+        return cached;
+    }
+
+    dff::DffData dffData;
+    if (!dffData.loadDffFile(path.c_str())) {
+        return nullptr;
+    }
+
+    auto model = std::make_shared<const dff::DffModel>(dffData.getModel());
+    Models().Insert(key, model, EstimateBytes(*model));
+    return model;
+}
+
+std::shared_ptr<const std::vector<CollisionModel>> AssetCache::LoadCol(uint32_t archiveIndex, uint32_t entryIndex,
+                                                                        std::span<const uint8_t> data) {
+    const uint64_t key = MakeKey(archiveIndex, entryIndex);
+    if (auto cached = Collisions().Find(key)) {
+        return cached;
+    }
+
+    std::vector<CollisionModel> decoded;
+    if (!loadColFromBuffer(data, decoded)) {
+        return nullptr;
+    }
+
+    auto models = std::make_shared<const std::vector<CollisionModel>>(std::move(decoded));
+    Collisions().Insert(key, models, EstimateBytes(*models));
+    return models;
+}
+
+std::string AssetCache::GetStatsString() {
+    auto describe = [](const char* label, size_t count, size_t used, size_t budget,
+                       size_t hits, size_t misses, size_t evictions) {
+        return std::string(label) + ": " + std::to_string(count) + " шт, " +
+               std::to_string(used / (1024 * 1024)) + "/" + std::to_string(budget / (1024 * 1024)) + " МБ, " +
+               "попаданий " + std::to_string(hits) + ", промахов " + std::to_string(misses) +
+               ", вытеснено " + std::to_string(evictions);
+    };
+
+    auto& models = Models();
+    auto& collisions = Collisions();
+    return describe("Модели", models.GetCount(), models.GetUsedBytes(), models.GetBudget(),
+                    models.GetHits(), models.GetMisses(), models.GetEvictions()) + "; " +
+           describe("Коллизии", collisions.GetCount(), collisions.GetUsedBytes(), collisions.GetBudget(),
+                    collisions.GetHits(), collisions.GetMisses(), collisions.GetEvictions());
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+#include "Loader.h"
+#include "CollisionGtaSaParser.h"
+
+// LRU кэш разобранных ассетов с ограничением по памяти.
+// Значения отдаются через shared_ptr: вытеснение не ломает тех, кто еще держит ассет.
+template <typename T>
+class LruAssetCache {
+public:
+    explicit LruAssetCache(size_t budgetBytes)
+        : m_budgetBytes(budgetBytes), m_usedBytes(0), m_hits(0), m_misses(0), m_evictions(0) {}
+
+    // Найти ассет; при попадании он становится самым свежим
+    std::shared_ptr<const T> Find(uint64_t key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_index.find(key);
+        if (it == m_index.end()) {
+            m_misses++;
+            return nullptr;
+        }
+
+        m_hits++;
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return it->second->value;
+    }
+
+    // Положить ассет; старые вытесняются, пока не уложимся в бюджет
+    void Insert(uint64_t key, std::shared_ptr<const T> value, size_t bytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_index.find(key);
+        if (it != m_index.end()) {
+            m_usedBytes -= it->second->bytes;
+            m_entries.erase(it->second);
+            m_index.erase(it);
+        }
+
+        // Ассет больше всего бюджета не кэшируем
+        if (bytes > m_budgetBytes) {
+            return;
+        }
+
+        m_entries.push_front({ key, std::move(value), bytes });
+        m_index[key] = m_entries.begin();
+        m_usedBytes += bytes;
+        EvictToBudget();
+    }
+
+    // Изменить бюджет (лишнее вытесняется сразу)
+    void SetBudget(size_t budgetBytes) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_budgetBytes = budgetBytes;
+        EvictToBudget();
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.clear();
+        m_index.clear();
+        m_usedBytes = 0;
+    }
+
+    // Статистика
+    size_t GetBudget() const { std::lock_guard<std::mutex> lock(m_mutex); return m_budgetBytes; }
+    size_t GetUsedBytes() const { std::lock_guard<std::mutex> lock(m_mutex); return m_usedBytes; }
+    size_t GetCount() const { std::lock_guard<std::mutex> lock(m_mutex); return m_entries.size(); }
+    size_t GetHits() const { std::lock_guard<std::mutex> lock(m_mutex); return m_hits; }
+    size_t GetMisses() const { std::lock_guard<std::mutex> lock(m_mutex); return m_misses; }
+    size_t GetEvictions() const { std::lock_guard<std::mutex> lock(m_mutex); return m_evictions; }
+
+private:
+    struct Node {
+        uint64_t key;
+        std::shared_ptr<const T> value;
+        size_t bytes;
+    };
+
+    void EvictToBudget() {
+        while (m_usedBytes > m_budgetBytes && !m_entries.empty()) {
+            const Node& oldest = m_entries.back();
+            m_usedBytes -= oldest.bytes;
+            m_index.erase(oldest.key);
+            m_entries.pop_back();
+            m_evictions++;
+        }
+    }
+
+    std::list<Node> m_entries;                                      // От свежих к старым
+    std::map<uint64_t, typename std::list<Node>::iterator> m_index;
+    size_t m_budgetBytes;
+    size_t m_usedBytes;
+    size_t m_hits;
+    size_t m_misses;
+    size_t m_evictions;
+    mutable std::mutex m_mutex;
+};
+
+// Индекс DFF файлов папки unpack: каталог читается один раз при первом обращении, дальше поиск -
+// обращение к таблице. Имена, для которых рабочей модели нет нигде, запоминаются (отрицательный кэш),
+// чтобы повторные размещения той же модели не искали и не разбирали ее снова.
+class UnpackIndex {
+public:
+    explicit UnpackIndex(std::string directory)
+        : m_directory(std::move(directory)), m_scanned(false) {}
+
+    // Путь к DFF модели в папке (пусто - файла нет)
+    std::string FindModel(std::string_view modelName);
+
+    // Отрицательный кэш: модель не нашлась или не разобралась
+    void MarkMissing(std::string_view modelName);
+    bool IsMissing(std::string_view modelName) const;
+
+    // Статистика
+    size_t GetFileCount();
+    size_t GetMissingCount() const { std::lock_guard<std::mutex> lock(m_mutex); return m_missing.size(); }
+
+private:
+    void ScanLocked();
+
+    std::string m_directory;
+    bool m_scanned;
+    std::unordered_map<std::string, std::string> m_files;   // Имя модели в нижнем регистре -> путь
+    std::unordered_set<std::string> m_missing;              // Имена в нижнем регистре
+    mutable std::mutex m_mutex;
+};
+
+// Общие кэши разобранных моделей и коллизий.
+// Ключ - (индекс архива в AssetIndex, индекс записи в его каталоге) первой копии содержимого;
+// для файлов с диска (папка unpack) - отдельное пространство ключей по пути.
+class AssetCache {
+public:
+    static LruAssetCache<dff::DffModel>& Models();
+    static LruAssetCache<std::vector<CollisionModel>>& Collisions();
+
+    // Индекс папки unpack (fallback для моделей, которых нет в IMG или которые не разобрались)
+    static UnpackIndex& Unpack();
+
+    // Ключ записи IMG архива
+    static uint64_t MakeKey(uint32_t archiveIndex, uint32_t entryIndex) {
+        return (static_cast<uint64_t>(archiveIndex) << 32) | entryIndex;
+    }
+
+    // Ключ файла на диске (путь приводится к нижнему регистру)
+    static uint64_t MakeFileKey(const std::string& path);
+
+    // Примерный объем памяти, занятый разобранным ассетом
+    static size_t EstimateBytes(const dff::DffModel& model);
+    static size_t EstimateBytes(const std::vector<CollisionModel>& models);
+
+    // Разобрать DFF файл с диска через кэш (nullptr - файл не разобрался)
+    static std::shared_ptr<const dff::DffModel> LoadDffFile(const std::string& path);
+
+    // Разобрать коллизии записи IMG архива через кэш (nullptr - в записи нет коллизий)
+    static std::shared_ptr<const std::vector<CollisionModel>> LoadCol(uint32_t archiveIndex, uint32_t entryIndex,
+                                                                      std::span<const uint8_t> data);
+
+    // Строка со статистикой обоих кэшей для лога
+    static std::string GetStatsString();
+
+private:
+    // Архив-метка для файлов с диска
+    static const uint32_t kDiskArchive = 0xFFFFFFFFu;
+};
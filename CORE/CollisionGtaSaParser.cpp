@@ -170,6 +170,67 @@ bool loadColFile(const char* filePath, std::vector<CollisionModel>& models) {
     return true;
 }
 
+// Загрузка заголовков всех коллизий из буфера (например, из представления файла в IMG)
+bool loadColFromBuffer(std::span<const uint8_t> data, std::vector<CollisionModel>& models) {
+    // FourCC(4) + размер(4) + имя(22) + ID(2) + bounds(40)
+    const size_t headerSize = 4 + 4 + 22 + 2 + 40;
+    size_t pos = 0;
+    size_t loadedCount = 0;
+    
+    while (pos + headerSize <= data.size()) {
+        const char* fourCC = reinterpret_cast<const char*>(data.data() + pos);
+        
+        int colVersion = 0;
+        if (strncmp(fourCC, "COLL", 4) == 0) colVersion = 1;
+        else if (strncmp(fourCC, "COL2", 4) == 0) colVersion = 2;
+        else if (strncmp(fourCC, "COL3", 4) == 0) colVersion = 3;
+        else if (strncmp(fourCC, "COL4", 4) == 0) colVersion = 4;
+        
+        // Конец списка коллизий (дальше выравнивание сектора нулями)
+        if (colVersion == 0) {
+            break;
+        }
+        
+        uint32_t sectionSize;
+        memcpy(&sectionSize, data.data() + pos + 4, 4);
+        
+        char nameBuffer[23];
+        memcpy(nameBuffer, data.data() + pos + 8, 22);
+        nameBuffer[22] = '\0';
+        
+        CollisionModel model;
+        model.name = std::string(nameBuffer);
+        while (!model.name.empty() && model.name.back() == ' ') {
+            model.name.pop_back();
+        }
+        memcpy(&model.modelId, data.data() + pos + 30, 2);
+        
+        float bounds[10];
+        memcpy(bounds, data.data() + pos + 32, sizeof(bounds));
+        if (colVersion == 1) {
+            // COLL: радиус, центр, min, max
+            model.radius = bounds[0];
+            model.centerX = bounds[1]; model.centerY = bounds[2]; model.centerZ = bounds[3];
+            model.minX = bounds[4]; model.minY = bounds[5]; model.minZ = bounds[6];
+            model.maxX = bounds[7]; model.maxY = bounds[8]; model.maxZ = bounds[9];
+        } else {
+            // COL2/COL3/COL4: min, max, центр, радиус
+            model.minX = bounds[0]; model.minY = bounds[1]; model.minZ = bounds[2];
+            model.maxX = bounds[3]; model.maxY = bounds[4]; model.maxZ = bounds[5];
+            model.centerX = bounds[6]; model.centerY = bounds[7]; model.centerZ = bounds[8];
+            model.radius = bounds[9];
+        }
+        
+        models.push_back(model);
+        loadedCount++;
+        
+        // Размер секции считается после FourCC и поля размера
+        pos += 8 + static_cast<size_t>(sectionSize);
+    }
+    
+    return loadedCount > 0;
+}
+
 // ============================================================================
 // НОВЫЕ ФУНКЦИИ ДЛЯ РАСПАКОВКИ .COL ФАЙЛОВ
 // ============================================================================
@@ -5,6 +5,7 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <span>
 #include <filesystem>
 
 // Структуры на основе анализа col3Importv1.02.ms скрипта
@@ -136,6 +137,7 @@ namespace ColFlags {
 
 // Функции для парсинга
 bool loadColFile(const char* filePath, std::vector<CollisionModel>& models);
+bool loadColFromBuffer(std::span<const uint8_t> data, std::vector<CollisionModel>& models);
 bool parseCol3Header(std::ifstream& file, Col3Header& header);
 bool parseCollisionSpheres(std::ifstream& file, CollisionModel& model, uint32_t offset, uint16_t count);
 bool parseCollisionBoxes(std::ifstream& file, CollisionModel& model, uint32_t offset, uint16_t count);
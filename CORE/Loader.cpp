@@ -1,10 +1,14 @@
 #include "Loader.h"
 #include "Logger.h"
+#include "ThreadPool.h"
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <cstring>
+#include <cstddef>
+#include <cmath>
+#include <charconv>
 #include <GL/glew.h>
 #include <vector>
 #include <string>
@@ -103,6 +107,16 @@ DataType dat::parseDataType(const std::string& keyword) {
     return DataType::UNKNOWN;
 }
 
+// Убрать пробелы и табуляции по краям (и \r от окончаний строк CRLF)
+static std::string_view trimIplLine(std::string_view line) {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) {
+        return {};
+    }
+    size_t last = line.find_last_not_of(" \t\r");
+    return line.substr(first, last - first + 1);
+}
+
 // Реализация класса ipl
 bool ipl::loadIplFile(const char* filePath, IplData& iplData) {
     if (!filePath) {
@@ -110,19 +124,41 @@ bool ipl::loadIplFile(const char* filePath, IplData& iplData) {
         return false;
     }
     
-    std::ifstream file(filePath);
+    std::ifstream file(filePath, std::ios::binary);
     if (!file.is_open()) {
         LogError("IPL: Не удалось открыть файл: " + std::string(filePath));
         return false;
     }
     
+    // Файл читается целиком, строки разбираются как string_view без копирования
+    file.seekg(0, std::ios::end);
+    std::string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(content.data(), content.size());
+    file.close();
+    
     iplData.clear();
     iplData.setFileName(filePath);
     
-    std::string line;
+    if (!parseIplText(content, iplData)) {
+        LogError("IPL: Ошибка парсинга секции INST в файле " + std::string(filePath));
+    }
+    return true;
+}
+
+bool ipl::parseIplText(std::string_view text, IplData& iplData) {
+    bool inInst = false;
+    bool sectionsClosed = true;
     int lineNumber = 0;
     
-    while (std::getline(file, line)) {
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t lineEnd = text.find('\n', position);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+        std::string_view line = trimIplLine(text.substr(position, lineEnd - position));
+        position = lineEnd + 1;
         lineNumber++;
         
         // Пропускаем пустые строки и комментарии
@@ -130,42 +166,19 @@ bool ipl::loadIplFile(const char* filePath, IplData& iplData) {
             continue;
         }
         
-        // Убираем лишние пробелы в начале и конце
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-        
-        if (line.empty()) continue;
-        
-        // Проверяем начало секции INST
-        if (line == "inst") {
-            if (!parseInstSection(file, iplData)) {
-                LogError("IPL: Ошибка парсинга секции INST на строке " + std::to_string(lineNumber));
+        if (!inInst) {
+            // Проверяем начало секции INST
+            if (line == "inst") {
+                inInst = true;
+                sectionsClosed = false;
             }
+            continue;
         }
-    }
-    
-    file.close();
-    return true;
-}
-
-bool ipl::parseInstSection(std::ifstream& file, IplData& iplData) {
-    std::string line;
-    int lineNumber = 0;
-    
-    while (std::getline(file, line)) {
-        lineNumber++;
-        
-        // Убираем лишние пробелы
-        line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
         
         // Проверяем конец секции
         if (line == "end") {
-            return true;
-        }
-        
-        // Пропускаем пустые строки и комментарии
-        if (line.empty() || line[0] == '#') {
+            inInst = false;
+            sectionsClosed = true;
             continue;
         }
         
@@ -176,10 +189,77 @@ bool ipl::parseInstSection(std::ifstream& file, IplData& iplData) {
         }
     }
     
-    return false; // Не найден конец секции
+    return sectionsClosed; // false - не найден конец секции
+}
+
+// Следующее поле строки INST: пробелы вокруг значения пропускаются, поле заканчивается запятой
+// (last == true - концом строки или пробелом перед хвостом)
+static bool nextInstField(const char*& cursor, const char* end, std::string_view& field, bool last) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t')) {
+        cursor++;
+    }
+    const char* fieldStart = cursor;
+    while (cursor < end && *cursor != ',') {
+        cursor++;
+    }
+    
+    const char* fieldEnd = cursor;
+    while (fieldEnd > fieldStart && (fieldEnd[-1] == ' ' || fieldEnd[-1] == '\t')) {
+        fieldEnd--;
+    }
+    field = std::string_view(fieldStart, fieldEnd - fieldStart);
+    
+    if (!last) {
+        if (cursor == end) {
+            return false;
+        }
+        cursor++; // Запятая
+    }
+    return true;
+}
+
+// Число из поля целиком (знак '+' допускается, как при чтении из потока)
+template<typename T>
+static bool parseInstNumber(std::string_view field, T& value, bool allowTail = false) {
+    const char* first = field.data();
+    const char* last = field.data() + field.size();
+    if (first < last && *first == '+') {
+        first++;
+    }
+    
+    auto result = std::from_chars(first, last, value);
+    if (result.ec != std::errc() || result.ptr == first) {
+        return false;
+    }
+    return allowTail || result.ptr == last;
+}
+
+bool ipl::parseInstLine(std::string_view line, IplObject& object) {
+    // Формат: ID, NAME, INTERIOR, X, Y, Z, RX, RY, RZ, RW, LOD
+    // Пример: 2001, u_panel_01, 0, 589.60840, 852.89099, 16.82146, 0.0, 0.0, 0.855037, 0.518567, 1
+    // 11 полей разбираются за один проход по строке, без потоков и выделения памяти
+    const char* cursor = line.data();
+    const char* end = line.data() + line.size();
+    std::string_view field;
+    
+    if (!nextInstField(cursor, end, field, false) || !parseInstNumber(field, object.modelId)) return false;
+    if (!nextInstField(cursor, end, field, false)) return false;
+    std::string_view name = field;
+    if (!nextInstField(cursor, end, field, false) || !parseInstNumber(field, object.interior)) return false;
+    
+    float* floats[] = { &object.x, &object.y, &object.z, &object.rx, &object.ry, &object.rz, &object.rw };
+    for (float* value : floats) {
+        if (!nextInstField(cursor, end, field, false) || !parseInstNumber(field, *value)) return false;
+    }
+    
+    // После LOD могут идти дополнительные поля - они игнорируются
+    if (!nextInstField(cursor, end, field, true) || !parseInstNumber(field, object.lod, true)) return false;
+    
+    object.name.assign(name.data(), name.size());
+    return true;
 }
 
-bool ipl::parseInstLine(const std::string& line, IplObject& object) {
+bool ipl::parseInstLineLegacy(const std::string& line, IplObject& object) {
     std::istringstream iss(line);
     std::string token;
     
@@ -232,6 +312,44 @@ bool ipl::parseInstLine(const std::string& line, IplObject& object) {
     return true;
 }
 
+bool ipl::isBinaryIpl(std::span<const uint8_t> data) {
+    return data.size() >= sizeof(BinaryIplHeader) && memcmp(data.data(), "bnry", 4) == 0;
+}
+
+bool ipl::loadBinaryIpl(std::span<const uint8_t> data, IplData& iplData) {
+    static_assert(sizeof(BinaryIplHeader) == 76, "Заголовок бинарного IPL - 76 байт");
+    static_assert(sizeof(BinaryIplInstance) == 40, "Запись INST бинарного IPL - 40 байт");
+    
+    if (!isBinaryIpl(data)) {
+        return false;
+    }
+    
+    BinaryIplHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.instanceCount < 0 || header.instanceOffset < 0) {
+        return false;
+    }
+    
+    // Записи фиксированного размера - читаются напрямую, без разбора текста
+    uint64_t instancesEnd = static_cast<uint64_t>(header.instanceOffset) + 
+                            static_cast<uint64_t>(header.instanceCount) * sizeof(BinaryIplInstance);
+    if (instancesEnd > data.size()) {
+        LogError("IPL: Бинарный IPL обрезан (" + std::to_string(header.instanceCount) + " объектов не помещаются в " + 
+                 std::to_string(data.size()) + " байт)");
+        return false;
+    }
+    
+    iplData.reserveObjects(header.instanceCount);
+    const uint8_t* record = data.data() + header.instanceOffset;
+    for (int32_t i = 0; i < header.instanceCount; i++, record += sizeof(BinaryIplInstance)) {
+        BinaryIplInstance instance;
+        memcpy(&instance, record, sizeof(instance));
+        iplData.addObject(IplObject(instance.modelId, "", instance.interior, instance.x, instance.y, instance.z,
+                                    instance.rx, instance.ry, instance.rz, instance.rw, instance.lod));
+    }
+    return true;
+}
+
 std::vector<ipl::IplObject> ipl::findObjectsByModelId(const IplData& iplData, int modelId) {
     std::vector<IplObject> result;
     for (const auto& obj : iplData.getAllObjects()) {
@@ -252,17 +370,196 @@ std::vector<ipl::IplObject> ipl::findObjectsByName(const IplData& iplData, const
     return result;
 }
 
+// ============================================================================
+// Реализация методов для работы с IDE файлами
+// ============================================================================
+
+// Наибольшее число полей строки IDE: tobj с тремя мешами (ID, модель, TXD, 1 + 3 дальности, флаги, 2 времени)
+static const size_t kMaxIdeFields = 10;
+
+// Имя модели для поиска без учета регистра
+static std::string lowerModelName(std::string_view name) {
+    std::string result(name);
+    std::transform(result.begin(), result.end(), result.begin(), ::tolower);
+    return result;
+}
+
+void ide::IdeData::addDefinition(const ObjectDefinition& definition) {
+    auto existing = definitions.find(definition.modelId);
+    if (existing != definitions.end()) {
+        auto nameIt = idsByName.find(lowerModelName(existing->second.modelName));
+        if (nameIt != idsByName.end() && nameIt->second == definition.modelId) {
+            idsByName.erase(nameIt);
+        }
+    }
+
+    definitions[definition.modelId] = definition;
+    idsByName[lowerModelName(definition.modelName)] = definition.modelId;
+}
+
+void ide::IdeData::merge(const IdeData& other) {
+    for (const auto& entry : other.definitions) {
+        addDefinition(entry.second);
+    }
+}
+
+const ide::ObjectDefinition* ide::IdeData::findById(int modelId) const {
+    auto it = definitions.find(modelId);
+    return it != definitions.end() ? &it->second : nullptr;
+}
+
+const ide::ObjectDefinition* ide::IdeData::findByName(std::string_view modelName) const {
+    auto it = idsByName.find(lowerModelName(modelName));
+    return it != idsByName.end() ? findById(it->second) : nullptr;
+}
+
+bool ide::loadIdeFile(const char* filePath, IdeData& ideData) {
+    if (!filePath) {
+        LogError("IDE: Путь к файлу пуст");
+        return false;
+    }
+
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file.is_open()) {
+        LogError("IDE: Не удалось открыть файл: " + std::string(filePath));
+        return false;
+    }
+
+    file.seekg(0, std::ios::end);
+    std::string content(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0, std::ios::beg);
+    file.read(content.data(), content.size());
+    file.close();
+
+    if (!parseIdeText(content, ideData)) {
+        LogError("IDE: Не найден конец секции в файле " + std::string(filePath));
+        return false;
+    }
+    return true;
+}
+
+bool ide::parseIdeText(std::string_view text, IdeData& ideData) {
+    bool inSection = false;
+    bool objectSection = false;
+    Section section = Section::Objs;
+
+    size_t position = 0;
+    while (position < text.size()) {
+        size_t lineEnd = text.find('\n', position);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = text.size();
+        }
+        std::string_view line = trimIplLine(text.substr(position, lineEnd - position));
+        position = lineEnd + 1;
+
+        // Пропускаем пустые строки и комментарии
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        if (!inSection) {
+            // Любое слово вне секции открывает секцию; разбираются только objs, tobj и anim
+            inSection = true;
+            objectSection = true;
+            if (line == "objs") section = Section::Objs;
+            else if (line == "tobj") section = Section::Tobj;
+            else if (line == "anim") section = Section::Anim;
+            else objectSection = false;
+            continue;
+        }
+
+        if (line == "end") {
+            inSection = false;
+            continue;
+        }
+
+        if (!objectSection) {
+            continue;
+        }
+
+        ObjectDefinition definition;
+        if (parseObjectLine(line, section, definition)) {
+            ideData.addDefinition(definition);
+        }
+    }
+
+    return !inSection; // false - не найден конец секции
+}
+
+bool ide::parseObjectLine(std::string_view line, Section section, ObjectDefinition& definition) {
+    // objs (SA):     ID, MODEL, TXD, DRAWDIST, FLAGS
+    // objs (III/VC): ID, MODEL, TXD, MESHCOUNT, DRAWDIST1[, DRAWDIST2[, DRAWDIST3]], FLAGS
+    // tobj:          те же поля + TIMEON, TIMEOFF
+    // anim:          ID, MODEL, TXD, ANIM, DRAWDIST, FLAGS
+    // Пример: 3983, lasrnway1_las, lasrnway_las, 299, 0
+    std::string_view fields[kMaxIdeFields + 1];
+    size_t count = 0;
+    size_t start = 0;
+    for (;;) {
+        if (count > kMaxIdeFields) {
+            return false;
+        }
+        size_t comma = line.find(',', start);
+        fields[count++] = trimIplLine(line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start));
+        if (comma == std::string_view::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+
+    const size_t timeFields = section == Section::Tobj ? 2 : 0;
+    if (count < 5 + timeFields) {
+        return false;
+    }
+    const size_t objectFields = count - timeFields;   // Поля до времени суток
+
+    if (!parseInstNumber(fields[0], definition.modelId)) return false;
+    if (fields[1].empty()) return false;
+    if (!parseInstNumber(fields[objectFields - 1], definition.flags)) return false;
+
+    size_t firstDistance = 3;
+    if (section == Section::Anim) {
+        if (objectFields != 6) return false;
+        definition.animName.assign(fields[3].data(), fields[3].size());
+        firstDistance = 4;
+    }
+    else if (objectFields > 5) {
+        // Формат с количеством мешей: у каждого меша своя дальность
+        int meshCount = 0;
+        if (!parseInstNumber(fields[3], meshCount) || meshCount < 1 || meshCount > 3) return false;
+        if (objectFields != 5 + static_cast<size_t>(meshCount)) return false;
+        firstDistance = 4;
+    }
+
+    definition.drawDistance = 0.0f;
+    for (size_t i = firstDistance; i < objectFields - 1; i++) {
+        float distance = 0.0f;
+        if (!parseInstNumber(fields[i], distance)) return false;
+        definition.drawDistance = std::max(definition.drawDistance, distance);
+    }
+
+    if (section == Section::Tobj) {
+        if (!parseInstNumber(fields[objectFields], definition.timeOn)) return false;
+        if (!parseInstNumber(fields[objectFields + 1], definition.timeOff)) return false;
+    }
+
+    definition.modelName.assign(fields[1].data(), fields[1].size());
+    definition.txdName.assign(fields[2].data(), fields[2].size());
+    definition.section = section;
+    return true;
+}
+
 // ============================================================================
 // Реализация методов для работы с IMG файлами
 // ============================================================================
 
 // Статическая функция для загрузки IMG файла
-bool img::loadImgFile(const char* filePath, ImgData& imgData) {
-    return imgData.loadImgFile(filePath);
+bool img::loadImgFile(const char* filePath, ImgData& imgData, ImgLoadMode mode) {
+    return imgData.loadImgFile(filePath, mode);
 }
 
 // Метод загрузки IMG файла (автоопределение версии)
-bool img::ImgData::loadImgFile(const char* filePath) {
+bool img::ImgData::loadImgFile(const char* filePath, ImgLoadMode mode) {
     if (!filePath) {
         //printf("[IMG] Ошибка: Путь к файлу пуст\n");
         return false;
@@ -280,45 +577,11 @@ bool img::ImgData::loadImgFile(const char* filePath) {
     this->version = detectImgVersion(file);
     this->isExtended = (version == ImgVersion::V2_EXTENDED_SA);
     
-    // Парсим заголовок
-    if (!parseHeader(file)) {
-        //printf("[IMG] Ошибка: Не удалось прочитать заголовок\n");
-        file.close();
-        return false;
-    }
-    
-    // Парсим записи файлов
-    if (!parseFileEntries(file, fileName)) {
-        //printf("[IMG] Ошибка: Не удалось прочитать записи файлов\n");
-        file.close();
-        return false;
-    }
-    
-    // Загружаем данные всех файлов
-    if (isExtended) {
-        // Для расширенного формата используем 64-битные записи
-        for (auto& entry : fileEntriesExtended) {
-            ImgFile imgFile;
-            if (loadFileDataExtended(file, entry, imgFile, fileName)) {
-                files[imgFile.name] = imgFile;
-            }
-        }
-    } else {
-        // Для стандартного формата используем 32-битные записи
-        for (auto& entry : fileEntries) {
-            ImgFile imgFile;
-            if (loadFileData(file, entry, imgFile, fileName)) {
-                files[imgFile.name] = imgFile;
-            }
-        }
-    }
-    
-    file.close();
-    return true;
+    return loadFromStream(file, mode);
 }
 
 // Принудительная загрузка определенной версии
-bool img::ImgData::loadImgFileVersion(const char* filePath, ImgVersion forcedVersion) {
+bool img::ImgData::loadImgFileVersion(const char* filePath, ImgVersion forcedVersion, ImgLoadMode mode) {
     if (!filePath) {
         //printf("[IMG] Ошибка: Путь к файлу пуст\n");
         return false;
@@ -334,6 +597,13 @@ bool img::ImgData::loadImgFileVersion(const char* filePath, ImgVersion forcedVer
     this->version = forcedVersion;
     this->isExtended = (version == ImgVersion::V2_EXTENDED_SA);
     
+    return loadFromStream(file, mode);
+}
+
+// Общая часть загрузки: заголовок, каталог и (в режиме Eager) данные файлов
+bool img::ImgData::loadFromStream(std::ifstream& file, ImgLoadMode mode) {
+    this->loadMode = mode;
+    
     // Парсим заголовок
     if (!parseHeader(file)) {
         //printf("[IMG] Ошибка: Не удалось прочитать заголовок\n");
@@ -348,27 +618,149 @@ bool img::ImgData::loadImgFileVersion(const char* filePath, ImgVersion forcedVer
         return false;
     }
     
+    buildEntryIndex();
+    
+    // В режиме Mapped данные файлов отдаются прямо из отображения архива
+    if (mode == ImgLoadMode::Mapped) {
+        if (mapArchive()) {
+            file.close();
+            return true;
+        }
+        
+        // Не удалось отобразить архив - откатываемся на ленивое чтение
+        printf("[IMG] Не удалось отобразить %s в память, используем ленивое чтение\n", fileName.c_str());
+        this->loadMode = ImgLoadMode::Lazy;
+        mode = ImgLoadMode::Lazy;
+    }
+    
+    // В ленивом режиме оставляем архив открытым и читаем данные по запросу
+    if (mode == ImgLoadMode::Lazy) {
+        dataStream = std::move(file);
+        return true;
+    }
+    
     // Загружаем данные всех файлов
+    for (const auto& pair : entryIndex) {
+        ImgFile imgFile;
+        if (readEntryData(file, pair.second, imgFile)) {
+            files[imgFile.name] = std::move(imgFile);
+        }
+    }
+    
+    file.close();
+    return true;
+}
+
+// Построить индекс имен по прочитанному каталогу
+void img::ImgData::buildEntryIndex() {
+    entryIndex.clear();
+    
+    // При совпадении имен побеждает последняя запись (как при заполнении files раньше)
     if (isExtended) {
-        for (auto& entry : fileEntriesExtended) {
-            ImgFile imgFile;
-            if (loadFileDataExtended(file, entry, imgFile, fileName)) {
-                files[imgFile.name] = imgFile;
-            }
+        for (size_t i = 0; i < fileEntriesExtended.size(); i++) {
+            entryIndex[std::string(fileEntriesExtended[i].name)] = i;
         }
     } else {
-        for (auto& entry : fileEntries) {
-            ImgFile imgFile;
-            if (loadFileData(file, entry, imgFile, fileName)) {
-                files[imgFile.name] = imgFile;
-            }
+        for (size_t i = 0; i < fileEntries.size(); i++) {
+            entryIndex[std::string(fileEntries[i].name)] = i;
         }
     }
+}
+
+// Прочитать данные записи каталога по ее индексу
+bool img::ImgData::readEntryData(std::ifstream& file, size_t index, ImgFile& imgFile) const {
+    if (isExtended) {
+        ImgFileEntryExtended entry = fileEntriesExtended[index];
+        return loadFileDataExtended(file, entry, imgFile, fileName);
+    }
     
-    file.close();
+    ImgFileEntry entry = fileEntries[index];
+    return loadFileData(file, entry, imgFile, fileName);
+}
+
+// Смещение и размер записи каталога в байтах
+void img::ImgData::getEntryRange(size_t index, uint64_t& offsetBytes, uint64_t& sizeBytes) const {
+    if (isExtended) {
+        offsetBytes = fileEntriesExtended[index].offset * 2048;
+        sizeBytes = fileEntriesExtended[index].streamingSize * 2048;
+    } else {
+        offsetBytes = static_cast<uint64_t>(fileEntries[index].offset) * 2048;
+        sizeBytes = static_cast<uint64_t>(fileEntries[index].streamingSize) * 2048;
+    }
+}
+
+// Байты записи каталога внутри отображенного архива
+std::span<const uint8_t> img::ImgData::getMappedEntryView(size_t index) const {
+    if (!mappedData) {
+        return {};
+    }
+    
+    uint64_t offsetBytes = 0;
+    uint64_t sizeBytes = 0;
+    getEntryRange(index, offsetBytes, sizeBytes);
+    
+    // Последний файл архива может быть не выровнен по сектору - обрезаем по концу отображения
+    if (offsetBytes >= mappedSize) {
+        return {};
+    }
+    sizeBytes = std::min(sizeBytes, mappedSize - offsetBytes);
+    
+    return std::span<const uint8_t>(mappedData + offsetBytes, static_cast<size_t>(sizeBytes));
+}
+
+// Отобразить архив в память только для чтения
+bool img::ImgData::mapArchive() {
+    unmapArchive();
+    
+    HANDLE hFile = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart <= 0) {
+        CloseHandle(hFile);
+        return false;
+    }
+    
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping) {
+        CloseHandle(hFile);
+        return false;
+    }
+    
+    void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+    
+    mapFileHandle = hFile;
+    mapViewHandle = hMapping;
+    mappedData = static_cast<const uint8_t*>(view);
+    mappedSize = static_cast<uint64_t>(size.QuadPart);
     return true;
 }
 
+// Снять отображение архива
+void img::ImgData::unmapArchive() {
+    if (mappedData) {
+        UnmapViewOfFile(mappedData);
+        mappedData = nullptr;
+    }
+    if (mapViewHandle) {
+        CloseHandle(mapViewHandle);
+        mapViewHandle = nullptr;
+    }
+    if (mapFileHandle) {
+        CloseHandle(mapFileHandle);
+        mapFileHandle = nullptr;
+    }
+    mappedSize = 0;
+}
+
 // Парсинг заголовка IMG
 bool img::ImgData::parseHeader(std::ifstream& file) {
     if (isExtended) {
@@ -465,7 +857,7 @@ bool img::ImgData::parseFileEntries(std::ifstream& file, const std::string& imgF
 }
 
 // Загрузка данных файла
-bool img::ImgData::loadFileData(std::ifstream& file, ImgFileEntry& entry, ImgFile& imgFile, const std::string& imgFileName) {
+bool img::ImgData::loadFileData(std::ifstream& file, ImgFileEntry& entry, ImgFile& imgFile, const std::string& imgFileName) const {
     // Конвертируем секторы в байты
     uint32_t offsetBytes = entry.offset * 2048;
     uint32_t sizeBytes = entry.streamingSize * 2048;
@@ -532,9 +924,9 @@ bool img::ImgData::loadFileData(std::ifstream& file, ImgFileEntry& entry, ImgFil
 // Получить список всех имен файлов
 std::vector<std::string> img::ImgData::getAllFileNames() const {
     std::vector<std::string> result;
-    result.reserve(files.size());
+    result.reserve(entryIndex.size());
     
-    for (const auto& pair : files) {
+    for (const auto& pair : entryIndex) {
         result.push_back(pair.first);
     }
     
@@ -543,40 +935,321 @@ std::vector<std::string> img::ImgData::getAllFileNames() const {
 
 // Получить файл по имени
 const img::ImgFile* img::ImgData::getFile(const std::string& fileName) const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    
     auto it = files.find(fileName);
     if (it != files.end()) {
         return &(it->second);
     }
-    return nullptr;
-}
-
-// Проверить существование файла
-bool img::ImgData::fileExists(const std::string& fileName) const {
-    return files.find(fileName) != files.end();
-}
+    
+    // В режиме Eager все данные уже в памяти - файла нет или он не прочитался
+    if (loadMode == ImgLoadMode::Eager) {
+        return nullptr;
+    }
+    
+    // В режиме Mapped копируем байты из отображения (для кода, которому нужен указатель на ImgFile)
+    if (loadMode == ImgLoadMode::Mapped) {
+        ImgFile imgFile;
+        if (!copyFile(fileName, imgFile)) {
+            return nullptr;
+        }
+        
+        auto inserted = files.emplace(fileName, std::move(imgFile));
+        return &(inserted.first->second);
+    }
+    
+    auto entryIt = entryIndex.find(fileName);
+    if (entryIt == entryIndex.end() || !dataStream.is_open()) {
+        return nullptr;
+    }
+    
+    // Первое обращение - читаем данные записи из архива
+    ImgFile imgFile;
+    dataStream.clear();
+    if (!readEntryData(dataStream, entryIt->second, imgFile)) {
+        return nullptr;
+    }
+    
+    auto inserted = files.emplace(fileName, std::move(imgFile));
+    return &(inserted.first->second);
+}
+
+// Скопировать файл в буфер вызывающего
+bool img::ImgData::copyFile(const std::string& fileName, ImgFile& file) const {
+    if (loadMode == ImgLoadMode::Mapped) {
+        auto entryIt = entryIndex.find(fileName);
+        if (entryIt == entryIndex.end() || !mappedData) {
+            return false;
+        }
+        
+        std::span<const uint8_t> view = getMappedEntryView(entryIt->second);
+        uint64_t offsetBytes = 0;
+        uint64_t sizeBytes = 0;
+        getEntryRange(entryIt->second, offsetBytes, sizeBytes);
+        file = ImgFile(fileName, std::vector<uint8_t>(view.begin(), view.end()),
+                       static_cast<size_t>(offsetBytes), view.size(), version);
+        return true;
+    }
+    
+    const ImgFile* cached = getFile(fileName);
+    if (!cached) {
+        return false;
+    }
+    file = *cached;
+    return true;
+}
+
+// Получить байты файла без копирования
+std::span<const uint8_t> img::ImgData::getFileView(const std::string& fileName) const {
+    if (loadMode == ImgLoadMode::Mapped) {
+        auto entryIt = entryIndex.find(fileName);
+        if (entryIt == entryIndex.end()) {
+            return {};
+        }
+        return getMappedEntryView(entryIt->second);
+    }
+    
+    // В остальных режимах отдаем представление кэшированного буфера (узлы map не переезжают)
+    const ImgFile* file = getFile(fileName);
+    if (!file) {
+        return {};
+    }
+    return std::span<const uint8_t>(file->data);
+}
+
+// Получить байты файла по индексу записи каталога без копирования
+std::span<const uint8_t> img::ImgData::getFileViewByIndex(size_t index) const {
+    if (index >= getEntryCount()) {
+        return {};
+    }
+    if (loadMode == ImgLoadMode::Mapped) {
+        return getMappedEntryView(index);
+    }
+    const char* entryName = getEntryName(index);
+    return getFileView(std::string(entryName, strnlen(entryName, 24)));
+}
+
+// Подкачать диапазон отображенного архива одним запросом к системе. PrefetchVirtualMemory есть
+// только с Windows 8, а сборка нацелена на Windows 7 - функция ищется во время выполнения
+// (структура диапазона объявлена здесь же), без нее подсказка просто не дается
+static void prefetchMappedRange(const uint8_t* data, uint64_t size) {
+    struct MemoryRange {
+        void* virtualAddress;
+        size_t numberOfBytes;
+    };
+    typedef BOOL (WINAPI* PrefetchVirtualMemoryFn)(HANDLE, ULONG_PTR, MemoryRange*, ULONG);
+    
+    static const PrefetchVirtualMemoryFn prefetchVirtualMemory = []() {
+        HMODULE kernel32 = GetModuleHandleA("kernel32.dll");
+        return kernel32 ? reinterpret_cast<PrefetchVirtualMemoryFn>(GetProcAddress(kernel32, "PrefetchVirtualMemory")) : nullptr;
+    }();
+    if (!prefetchVirtualMemory) {
+        return;
+    }
+    
+    MemoryRange range;
+    range.virtualAddress = const_cast<uint8_t*>(data);
+    range.numberOfBytes = static_cast<size_t>(size);
+    prefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+// Пакетное чтение файлов со слиянием соседних диапазонов секторов
+bool img::ImgData::fetchBatch(const std::vector<std::string>& fileNames, ImgBatch& batch, uint32_t maxGapSectors) const {
+    batch.buffers.clear();
+    batch.views.assign(fileNames.size(), ImgFileView{});
+    batch.runCount = 0;
+    batch.bytesRead = 0;
+    
+    // Запрошенная запись: диапазон в архиве и позиция в списке имен
+    struct Request {
+        uint64_t offset;
+        uint64_t size;
+        size_t slot;
+    };
+    
+    std::vector<Request> requests;
+    requests.reserve(fileNames.size());
+    for (size_t i = 0; i < fileNames.size(); i++) {
+        auto entryIt = entryIndex.find(fileNames[i]);
+        if (entryIt == entryIndex.end()) {
+            continue;
+        }
+        
+        batch.views[i].name = entryIt->first;
+        Request request;
+        getEntryRange(entryIt->second, request.offset, request.size);
+        request.slot = i;
+        if (request.size > 0) {
+            requests.push_back(request);
+        }
+    }
+    
+    if (requests.empty()) {
+        return true;
+    }
+    
+    // В режиме Eager данные уже в памяти - чтений нет
+    if (loadMode == ImgLoadMode::Eager) {
+        for (const auto& request : requests) {
+            batch.views[request.slot].data = getFileView(fileNames[request.slot]);
+        }
+        return true;
+    }
+    
+    std::sort(requests.begin(), requests.end(), [](const Request& a, const Request& b) {
+        return a.offset < b.offset;
+    });
+    
+    const uint64_t maxGapBytes = static_cast<uint64_t>(maxGapSectors) * 2048;
+    
+    std::unique_lock<std::mutex> lock(dataMutex, std::defer_lock);
+    if (loadMode == ImgLoadMode::Lazy) {
+        if (!dataStream.is_open()) {
+            return false;
+        }
+        lock.lock();
+    }
+    
+    size_t runBegin = 0;
+    while (runBegin < requests.size()) {
+        // Расширяем диапазон, пока следующий файл начинается не дальше maxGapSectors от его конца
+        uint64_t runStart = requests[runBegin].offset;
+        uint64_t runEnd = runStart + requests[runBegin].size;
+        size_t runEndIndex = runBegin + 1;
+        while (runEndIndex < requests.size() && requests[runEndIndex].offset <= runEnd + maxGapBytes) {
+            runEnd = std::max(runEnd, requests[runEndIndex].offset + requests[runEndIndex].size);
+            runEndIndex++;
+        }
+        
+        const uint8_t* runData = nullptr;
+        uint64_t runAvailable = 0;
+        
+        if (loadMode == ImgLoadMode::Mapped) {
+            // Данные уже отображены: заранее подкачиваем весь диапазон одним запросом к системе
+            if (mappedData && runStart < mappedSize) {
+                runAvailable = std::min(runEnd, mappedSize) - runStart;
+                runData = mappedData + runStart;
+                
+                prefetchMappedRange(runData, runAvailable);
+            }
+        } else {
+            // Одно последовательное чтение на весь диапазон
+            std::vector<uint8_t> buffer(static_cast<size_t>(runEnd - runStart));
+            dataStream.clear();
+            dataStream.seekg(static_cast<std::streamoff>(runStart));
+            dataStream.read(reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+            
+            // Последний файл архива может быть короче сектора - оставляем то, что прочиталось
+            runAvailable = static_cast<uint64_t>(std::max<std::streamsize>(dataStream.gcount(), 0));
+            buffer.resize(static_cast<size_t>(runAvailable));
+            batch.buffers.push_back(std::move(buffer));
+            runData = batch.buffers.back().data();
+        }
+        
+        batch.runCount++;
+        batch.bytesRead += runAvailable;
+        
+        // Раздаем файлам их части диапазона
+        for (size_t i = runBegin; i < runEndIndex; i++) {
+            uint64_t relative = requests[i].offset - runStart;
+            if (!runData || relative >= runAvailable) {
+                continue;
+            }
+            uint64_t size = std::min(requests[i].size, runAvailable - relative);
+            batch.views[requests[i].slot].data = std::span<const uint8_t>(runData + relative, static_cast<size_t>(size));
+        }
+        
+        runBegin = runEndIndex;
+    }
+    
+    return true;
+}
+
+// Проверить существование файла
+bool img::ImgData::fileExists(const std::string& fileName) const {
+    return entryIndex.find(fileName) != entryIndex.end();
+}
 
 // Получить файлы по расширению
 std::vector<img::ImgFile> img::ImgData::getFilesByExtension(const std::string& ext) const {
     std::vector<ImgFile> result;
     
-    for (const auto& pair : files) {
-        if (pair.second.extension == ext) {
-            result.push_back(pair.second);
+    for (const auto& pair : entryIndex) {
+        size_t dotPos = pair.first.find_last_of('.');
+        if (dotPos == std::string::npos || pair.first.compare(dotPos, std::string::npos, ext) != 0) {
+            continue;
+        }
+        
+        ImgFile file;
+        if (copyFile(pair.first, file)) {
+            result.push_back(std::move(file));
+        }
+    }
+    
+    return result;
+}
+
+// Получить представления файлов по расширению без копирования данных
+std::vector<img::ImgFileView> img::ImgData::getFileViewsByExtension(const std::string& ext) const {
+    std::vector<ImgFileView> result;
+    
+    for (const auto& pair : entryIndex) {
+        size_t dotPos = pair.first.find_last_of('.');
+        if (dotPos == std::string::npos || pair.first.compare(dotPos, std::string::npos, ext) != 0) {
+            continue;
+        }
+        
+        std::span<const uint8_t> data = getFileView(pair.first);
+        if (!data.empty()) {
+            result.push_back({ pair.first, data });
         }
     }
     
     return result;
 }
 
+// Посчитать файлы по расширению без чтения их данных
+size_t img::ImgData::getFileCountByExtension(const std::string& ext) const {
+    size_t count = 0;
+    
+    for (const auto& pair : entryIndex) {
+        size_t dotPos = pair.first.find_last_of('.');
+        if (dotPos != std::string::npos && pair.first.compare(dotPos, std::string::npos, ext) == 0) {
+            count++;
+        }
+    }
+    
+    return count;
+}
+
+// Количество файлов, данные которых уже прочитаны в память
+size_t img::ImgData::getLoadedFileCount() const {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    return files.size();
+}
+
+// Деструктор: отображение и открытый поток должны быть закрыты вместе с архивом
+img::ImgData::~ImgData() {
+    clear();
+}
+
 // Очистить все данные
 void img::ImgData::clear() {
+    std::lock_guard<std::mutex> lock(dataMutex);
+    
     fileName.clear();
     memset(&header, 0, sizeof(header));
     memset(&headerExtended, 0, sizeof(headerExtended));
     fileEntries.clear();
     fileEntriesExtended.clear();
+    entryIndex.clear();
     files.clear();
+    if (dataStream.is_open()) {
+        dataStream.close();
+    }
+    unmapArchive();
     version = ImgVersion::V2_GTA_SA;
+    loadMode = ImgLoadMode::Eager;
     isExtended = false;
 }
 
@@ -590,9 +1263,9 @@ std::vector<img::ImgFile> img::findFilesByNamePattern(const ImgData& imgData, co
     
     for (const auto& fileName : imgData.getAllFileNames()) {
         if (fileName.find(pattern) != std::string::npos) {
-            const ImgFile* file = imgData.getFile(fileName);
-            if (file) {
-                result.push_back(*file);
+            ImgFile file;
+            if (imgData.copyFile(fileName, file)) {
+                result.push_back(std::move(file));
             }
         }
     }
@@ -617,16 +1290,275 @@ const img::ImgFile* img::findModelByName(const std::vector<ImgData*>& imgArchive
 
 // Получить данные модели по названию
 std::vector<uint8_t> img::getModelData(const std::vector<ImgData*>& imgArchives, const std::string& modelName) {
-    const ImgFile* file = findModelByName(imgArchives, modelName);
-    if (file) {
-        return file->data;
+    // Одна копия из представления: байты не оседают в кэше архива
+    std::span<const uint8_t> view = getModelView(imgArchives, modelName);
+    return std::vector<uint8_t>(view.begin(), view.end()); // Пустой вектор если модель не найдена
+}
+
+// Получить байты модели по названию без копирования (первый архив, где она есть)
+std::span<const uint8_t> img::getModelView(const std::vector<ImgData*>& imgArchives, const std::string& modelName) {
+    for (const auto& imgData : imgArchives) {
+        if (imgData && imgData->fileExists(modelName)) {
+            std::span<const uint8_t> view = imgData->getFileView(modelName);
+            if (!view.empty()) {
+                return view;
+            }
         }
-    return std::vector<uint8_t>(); // Пустой вектор если модель не найдена
+    }
+    return {};
 }
 
-// Проверить существование модели
+// Проверить существование модели (по каталогу, без чтения данных)
 bool img::modelExists(const std::vector<ImgData*>& imgArchives, const std::string& modelName) {
-    return findModelByName(imgArchives, modelName) != nullptr;
+    for (const auto& imgData : imgArchives) {
+        if (imgData && imgData->fileExists(modelName)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Глобальный индекс файлов IMG архивов
+// ============================================================================
+
+// Привести имя к ключу индекса
+bool img::AssetIndex::makeKey(std::string_view fileName, char key[24]) {
+    // Имя в каталоге IMG занимает не больше 24 байт, длиннее не бывает
+    if (fileName.empty() || fileName.size() > 24) {
+        return false;
+    }
+    
+    memset(key, 0, 24);
+    for (size_t i = 0; i < fileName.size(); i++) {
+        char c = fileName[i];
+        key[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+    return true;
+}
+
+// Хэш ключа: три 64-битных слова + финальное перемешивание (как fmix64 в MurmurHash3)
+uint64_t img::AssetIndex::hashKey(const char key[24]) {
+    uint64_t words[3];
+    memcpy(words, key, 24);
+    
+    uint64_t h = words[0] * 0x9E3779B97F4A7C15ULL;
+    h ^= words[1] * 0xC2B2AE3D27D4EB4FULL;
+    h ^= words[2] * 0x165667B19E3779F9ULL;
+    
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Построить индекс по списку архивов
+void img::AssetIndex::build(const std::vector<ImgData*>& imgArchives) {
+    clear();
+    archives = imgArchives;
+    
+    size_t totalEntries = 0;
+    for (const auto* imgData : imgArchives) {
+        if (imgData) {
+            totalEntries += imgData->getEntryCount();
+        }
+    }
+    
+    // Заполнение не больше 50% - в среднем поиск укладывается в одну пробу
+    size_t capacity = 16;
+    while (capacity < totalEntries * 2) {
+        capacity <<= 1;
+    }
+    slots.assign(capacity, Entry{});
+    const size_t mask = capacity - 1;
+    
+    for (size_t archiveIndex = 0; archiveIndex < imgArchives.size(); archiveIndex++) {
+        const ImgData* imgData = imgArchives[archiveIndex];
+        if (!imgData) {
+            continue;
+        }
+        
+        for (size_t entryIndex = 0; entryIndex < imgData->getEntryCount(); entryIndex++) {
+            char key[24];
+            const char* entryName = imgData->getEntryName(entryIndex);
+            if (!makeKey(std::string_view(entryName, strnlen(entryName, 24)), key)) {
+                continue;
+            }
+            uint64_t hash = hashKey(key);
+            
+            size_t slot = static_cast<size_t>(hash) & mask;
+            size_t probe = 1;
+            while (slots[slot].key[0] != 0 &&
+                   !(slots[slot].hash == hash && memcmp(slots[slot].key, key, 24) == 0)) {
+                slot = (slot + 1) & mask;
+                probe++;
+            }
+            maxProbe = std::max(maxProbe, probe);
+            
+            Entry& entry = slots[slot];
+            if (entry.key[0] == 0) {
+                memcpy(entry.key, key, 24);
+                entry.hash = hash;
+                entry.archive = static_cast<uint32_t>(archiveIndex);
+                entry.entry = static_cast<uint32_t>(entryIndex);
+                entry.contentHash = 0;
+                entry.contentArchive = entry.archive;
+                entry.contentEntry = entry.entry;
+                count++;
+            } else if (entry.archive == archiveIndex) {
+                // Повтор внутри одного архива - побеждает последняя запись (как в ImgData)
+                entry.entry = static_cast<uint32_t>(entryIndex);
+                entry.contentEntry = entry.entry;
+            } else {
+                // Имя уже есть в более приоритетном архиве
+                shadowedCount++;
+            }
+        }
+    }
+}
+
+// Найти запись по имени файла
+const img::AssetIndex::Entry* img::AssetIndex::find(std::string_view fileName) const {
+    char key[24];
+    if (slots.empty() || !makeKey(fileName, key)) {
+        return nullptr;
+    }
+    
+    uint64_t hash = hashKey(key);
+    const size_t mask = slots.size() - 1;
+    for (size_t slot = static_cast<size_t>(hash) & mask; slots[slot].key[0] != 0; slot = (slot + 1) & mask) {
+        if (slots[slot].hash == hash && memcmp(slots[slot].key, key, 24) == 0) {
+            return &slots[slot];
+        }
+    }
+    return nullptr;
+}
+
+// Получить байты файла без копирования
+std::span<const uint8_t> img::AssetIndex::getView(std::string_view fileName) const {
+    const Entry* entry = find(fileName);
+    if (!entry) {
+        return {};
+    }
+    ContentRef content = getContent(*entry);
+    return archives[content.archive]->getFileViewByIndex(content.entry);
+}
+
+// Хэш содержимого: 64-битные слова, умножение и перемешивание битов
+uint64_t img::AssetIndex::hashContent(std::span<const uint8_t> data) {
+    const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+    const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+    
+    uint64_t hash = 0x27D4EB2F165667C5ull ^ (data.size() * prime1);
+    size_t offset = 0;
+    for (; offset + 8 <= data.size(); offset += 8) {
+        uint64_t word;
+        memcpy(&word, data.data() + offset, 8);
+        hash ^= word * prime2;
+        hash = ((hash << 31) | (hash >> 33)) * prime1;
+    }
+    
+    // Хвост короче 8 байт
+    if (offset < data.size()) {
+        uint64_t tail = 0;
+        memcpy(&tail, data.data() + offset, data.size() - offset);
+        hash ^= tail * prime2;
+    }
+    
+    // Финальное перемешивание
+    hash ^= hash >> 33;
+    hash *= prime2;
+    hash ^= hash >> 29;
+    return hash ? hash : 1;
+}
+
+// Байты содержимого без добивки: у файлов RenderWare (модель, словарь текстур) размер - из заголовка
+// первого блока, у остальных отбрасываются нули последнего сектора
+std::span<const uint8_t> img::AssetIndex::contentBytes(std::span<const uint8_t> data) {
+    if (data.size() >= 12) {
+        uint32_t chunkType = 0, chunkSize = 0;
+        memcpy(&chunkType, data.data(), 4);
+        memcpy(&chunkSize, data.data() + 4, 4);
+        if ((chunkType == 0x10 || chunkType == 0x16) && chunkSize <= data.size() - 12) {
+            return data.first(12 + static_cast<size_t>(chunkSize));
+        }
+    }
+    
+    size_t size = data.size();
+    const size_t minSize = size > 2048 ? size - 2048 : 0;
+    while (size > minSize && data[size - 1] == 0) {
+        size--;
+    }
+    return data.first(size);
+}
+
+// Первая копия содержимого записи (хэш - при первом запросе)
+img::AssetIndex::ContentRef img::AssetIndex::getContent(const Entry& entry) const {
+    {
+        std::lock_guard<std::mutex> lock(contentMutex);
+        if (entry.contentHash != 0) {
+            return { entry.contentArchive, entry.contentEntry };
+        }
+    }
+    
+    // Ленивый архив для хэша пришлось бы прочитать - запись остается сама себе первой копией
+    const ImgData* archive = archives[entry.archive];
+    if (archive->getLoadMode() == ImgLoadMode::Lazy) {
+        return { entry.archive, entry.entry };
+    }
+    
+    // Хэш считается без блокировки: параллельные запросы разных записей не ждут друг друга
+    std::span<const uint8_t> data = contentBytes(archive->getFileViewByIndex(entry.entry));
+    if (data.empty()) {
+        return { entry.archive, entry.entry };
+    }
+    const uint64_t contentHash = hashContent(data);
+    
+    std::lock_guard<std::mutex> lock(contentMutex);
+    Entry& resolved = const_cast<Entry&>(entry);
+    if (resolved.contentHash != 0) {
+        return { resolved.contentArchive, resolved.contentEntry };
+    }
+    
+    // Совпадение хэша подтверждается сравнением байтов
+    std::vector<ContentRef>& candidates = firstCopies[contentHash];
+    ContentRef content = { entry.archive, entry.entry };
+    bool duplicate = false;
+    for (const ContentRef& candidate : candidates) {
+        std::span<const uint8_t> candidateData = contentBytes(archives[candidate.archive]->getFileViewByIndex(candidate.entry));
+        if (candidateData.size() == data.size() && memcmp(candidateData.data(), data.data(), data.size()) == 0) {
+            content = candidate;
+            duplicate = true;
+            break;
+        }
+    }
+    
+    if (duplicate) {
+        dedupCount++;
+        dedupBytes += data.size();
+    } else {
+        candidates.push_back(content);
+    }
+    resolved.contentHash = contentHash;
+    resolved.contentArchive = content.archive;
+    resolved.contentEntry = content.entry;
+    return content;
+}
+
+// Очистить индекс
+void img::AssetIndex::clear() {
+    slots.clear();
+    archives.clear();
+    count = 0;
+    shadowedCount = 0;
+    maxProbe = 0;
+    
+    std::lock_guard<std::mutex> lock(contentMutex);
+    firstCopies.clear();
+    dedupCount = 0;
+    dedupBytes = 0;
 }
 
 // Автопоиск .img файлов в папке models
@@ -661,7 +1593,7 @@ std::vector<std::string> img::findImgFilesInModelsFolder() {
 // ============================================================================
 
 // Загрузка данных файла для расширенного формата (64-битные размеры)
-bool img::ImgData::loadFileDataExtended(std::ifstream& file, ImgFileEntryExtended& entry, ImgFile& imgFile, const std::string& imgFileName) {
+bool img::ImgData::loadFileDataExtended(std::ifstream& file, ImgFileEntryExtended& entry, ImgFile& imgFile, const std::string& imgFileName) const {
     // Конвертируем секторы в байты (64-битные)
     uint64_t offsetBytes = entry.offset * 2048;
     uint64_t sizeBytes = entry.streamingSize * 2048;
@@ -856,6 +1788,194 @@ uint64_t img::bytesToSectors(uint64_t bytes) {
     return (bytes + 2047) / 2048; // Округление вверх
 }
 
+// ============================================================================
+// ПЕРЕУПАКОВКА IMG ПО ПОЛОЖЕНИЮ В МИРЕ
+// ============================================================================
+
+// Код Мортона: чередование битов двух 16-битных координат
+static uint32_t mortonCode2D(uint32_t x, uint32_t y) {
+    auto spread = [](uint32_t v) {
+        v &= 0xFFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+// Переупаковать архив с порядком файлов по кривой Мортона
+bool img::repackImgSpatial(const ImgData& source, const std::vector<ipl::IplObject>& objects,
+                           const char* outputPath, RepackStats* stats) {
+    if (!outputPath || source.getEntryCount() == 0) {
+        return false;
+    }
+    
+    // Границы мира по объектам IPL
+    float minX = 0.0f, minY = 0.0f, maxX = 1.0f, maxY = 1.0f;
+    if (!objects.empty()) {
+        minX = maxX = objects[0].x;
+        minY = maxY = objects[0].y;
+        for (const auto& obj : objects) {
+            minX = std::min(minX, obj.x);
+            maxX = std::max(maxX, obj.x);
+            minY = std::min(minY, obj.y);
+            maxY = std::max(maxY, obj.y);
+        }
+    }
+    const float scaleX = 65535.0f / std::max(maxX - minX, 1.0f);
+    const float scaleY = 65535.0f / std::max(maxY - minY, 1.0f);
+    
+    // Для каждого имени модели - минимальный код Мортона среди ее размещений:
+    // модель попадает в файл рядом с первым по кривой районом, где она встречается
+    std::map<std::string, uint32_t> modelCodes;
+    for (const auto& obj : objects) {
+        uint32_t code = mortonCode2D(static_cast<uint32_t>((obj.x - minX) * scaleX),
+                                     static_cast<uint32_t>((obj.y - minY) * scaleY));
+        
+        // LOD версии - отдельные объекты IPL, их модели попадают сюда под своими именами
+        std::string fileName = obj.name + ".dff";
+        std::transform(fileName.begin(), fileName.end(), fileName.begin(), ::tolower);
+        
+        auto it = modelCodes.find(fileName);
+        if (it == modelCodes.end() || code < it->second) {
+            modelCodes[fileName] = code;
+        }
+    }
+    
+    // Порядок записей: сначала размещенные по коду Мортона, затем остальные по исходному смещению
+    struct RepackEntry {
+        size_t index;
+        bool placed;
+        uint32_t code;
+        uint64_t offset;
+        uint64_t size;
+    };
+    
+    std::vector<RepackEntry> order;
+    order.reserve(source.getEntryCount());
+    for (size_t i = 0; i < source.getEntryCount(); i++) {
+        const char* entryName = source.getEntryName(i);
+        std::string name(entryName, strnlen(entryName, 24));
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        
+        RepackEntry entry;
+        entry.index = i;
+        auto it = modelCodes.find(name);
+        entry.placed = it != modelCodes.end();
+        entry.code = entry.placed ? it->second : 0;
+        source.getEntryRange(i, entry.offset, entry.size);
+        order.push_back(entry);
+    }
+    
+    std::stable_sort(order.begin(), order.end(), [](const RepackEntry& a, const RepackEntry& b) {
+        if (a.placed != b.placed) return a.placed;
+        if (a.placed && a.code != b.code) return a.code < b.code;
+        return a.offset < b.offset;
+    });
+    
+    // Каталог VER2: заголовок 8 байт + 32 байта на запись, данные с границы сектора
+    const uint64_t directoryBytes = 8 + 32ULL * order.size();
+    // Данные не начинаем с сектора 1: detectImgVersion принимает смещение первой записи,
+    // равное 1, за флаг расширенного формата
+    uint64_t nextSector = std::max<uint64_t>(bytesToSectors(directoryBytes), 2);
+    
+    std::vector<ImgFileEntry> directory(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        uint64_t sizeSectors = bytesToSectors(order[i].size);
+        if (nextSector > 0xFFFFFFFFULL || sizeSectors > 0xFFFF) {
+            printf("[IMG] Переупаковка: запись %zu не помещается в формат VER2\n", order[i].index);
+            return false;
+        }
+        
+        ImgFileEntry& entry = directory[i];
+        memset(&entry, 0, sizeof(entry));
+        entry.offset = static_cast<uint32_t>(nextSector);
+        entry.streamingSize = static_cast<uint16_t>(sizeSectors);
+        entry.archiveSize = 0;
+        memcpy(entry.name, source.getEntryName(order[i].index), strnlen(source.getEntryName(order[i].index), 24));
+        nextSector += sizeSectors;
+    }
+    
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        printf("[IMG] Переупаковка: не удалось создать файл %s\n", outputPath);
+        return false;
+    }
+    
+    ImgHeader header;
+    memcpy(header.magic, "VER2", 4);
+    header.fileCount = static_cast<uint32_t>(directory.size());
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(directory.data()), directory.size() * sizeof(ImgFileEntry));
+    
+    // Исходные данные читаются по одной записи: при отображении - представления, при ленивом
+    // открытии - общий буфер (иначе каждая запись осела бы в кэше архива)
+    const bool streamEntries = source.getLoadMode() == ImgLoadMode::Lazy;
+    std::ifstream in;
+    std::vector<uint8_t> entryBuffer;
+    if (streamEntries) {
+        in.open(source.getFileName(), std::ios::binary);
+        if (!in.is_open()) {
+            printf("[IMG] Переупаковка: не удалось открыть %s\n", source.getFileName().c_str());
+            return false;
+        }
+    }
+    
+    // Данные файлов в новом порядке, каждый добит нулями до границы сектора
+    std::vector<char> padding(2048, 0);
+    uint64_t written = directoryBytes;
+    for (size_t i = 0; i < order.size(); i++) {
+        uint64_t targetOffset = sectorsToBytes(directory[i].offset);
+        while (written < targetOffset) {
+            size_t chunk = static_cast<size_t>(std::min<uint64_t>(padding.size(), targetOffset - written));
+            out.write(padding.data(), chunk);
+            written += chunk;
+        }
+        
+        std::span<const uint8_t> data;
+        if (streamEntries) {
+            entryBuffer.resize(static_cast<size_t>(order[i].size));
+            in.clear();
+            in.seekg(static_cast<std::streamoff>(order[i].offset));
+            in.read(reinterpret_cast<char*>(entryBuffer.data()), entryBuffer.size());
+            data = std::span<const uint8_t>(entryBuffer.data(), static_cast<size_t>(in.gcount()));
+        }
+        else {
+            data = source.getFileViewByIndex(order[i].index);
+        }
+        size_t dataSize = std::min<size_t>(data.size(), static_cast<size_t>(sectorsToBytes(directory[i].streamingSize)));
+        out.write(reinterpret_cast<const char*>(data.data()), dataSize);
+        written += dataSize;
+    }
+    
+    // Последний файл тоже выравниваем по сектору
+    uint64_t totalBytes = sectorsToBytes(nextSector);
+    while (written < totalBytes) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(padding.size(), totalBytes - written));
+        out.write(padding.data(), chunk);
+        written += chunk;
+    }
+    
+    if (!out.good()) {
+        printf("[IMG] Переупаковка: ошибка записи %s\n", outputPath);
+        return false;
+    }
+    out.close();
+    
+    if (stats) {
+        stats->placedEntries = 0;
+        for (const auto& entry : order) {
+            if (entry.placed) stats->placedEntries++;
+        }
+        stats->unplacedEntries = order.size() - stats->placedEntries;
+        stats->outputSectors = nextSector;
+    }
+    
+    return true;
+}
+
 // ============================================================================
 // DFF PARSER IMPLEMENTATION - ИСПОЛЬЗУЕМ КОД ИЗ DffImporter
 // ============================================================================
@@ -910,16 +2030,16 @@ namespace extensions {
         uint32_t size;
         uint32_t fileVersion;
 
-        bool checkVersion() {
+        bool checkVersion() const {
             return (this->fileVersion == GTA_IIIA || this->fileVersion == GTA_IIIB || this->fileVersion == GTA_IIIC
                 || this->fileVersion == GTA_VCA || this->fileVersion == GTA_VCB || this->fileVersion == GTA_SA);
         }
 
-        bool operator == (const uint32_t& secID) {
+        bool operator == (const uint32_t& secID) const {
             return (this->identifier == secID && this->checkVersion());
         }
 
-        uint32_t getIdentifier() {
+        uint32_t getIdentifier() const {
             if (checkVersion())
                 return this->identifier;
             else
@@ -1020,12 +2140,12 @@ bool dff::loadDffFile(const char* filePath, DffData& dffData) {
 }
 
 // Загрузка DFF из буфера
-bool dff::loadDffFromBuffer(const std::vector<uint8_t>& data, DffData& dffData, const std::string& name) {
+bool dff::loadDffFromBuffer(std::span<const uint8_t> data, DffData& dffData, const std::string& name) {
     return dffData.loadDffFromBuffer(data, name);
 }
 
 // Создание DFF модели
-dff::DffModel* dff::createDffModel(const std::vector<uint8_t>& data, const std::string& name) {
+dff::DffModel* dff::createDffModel(std::span<const uint8_t> data, const std::string& name) {
     DffData dffData;
     if (dffData.loadDffFromBuffer(data, name)) {
         return new DffModel(dffData.getModel());
@@ -1037,35 +2157,92 @@ dff::DffModel* dff::createDffModel(const std::vector<uint8_t>& data, const std::
 // DffData IMPLEMENTATION
 // ============================================================================
 
-dff::DffData::DffData() : buffer(nullptr), bufIndex(0), fileSize(0), noIssues(true) {
-}
-
-dff::DffData::~DffData() {
-    clear();
+// Секция с известной версией RenderWare (GTA III / VC / SA)
+static bool isKnownRwVersion(const dff::Chunk& chunk) {
+    const extensions::GTAHeader header = { chunk.id, chunk.size, chunk.version };
+    return header.checkVersion();
 }
 
-bool dff::DffData::loadDffFile(const char* filePath) {
-    printf("[DFF] Загружаем DFF файл: %s\n", filePath);
-    
-    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
-    if (!file.is_open()) {
-        printf("[DFF] Ошибка: Не удалось открыть файл: %s\n", filePath);
+bool dff::ChunkWalker::next(Chunk& chunk) {
+    if (m_failed || m_offset == m_data.size()) {
         return false;
     }
     
-    this->fileSize = file.tellg();
-    this->buffer = new char[this->fileSize];
-    this->bufIndex = 0;
-    this->noIssues = true;
-    this->fileName = filePath;
-    
-    file.seekg(0, std::ios::beg);
-    file.read(buffer, fileSize);
-    file.close();
-    
-    printf("[DFF] Файл загружен, размер: %zu байт\n", fileSize);
+    // Заголовок и содержимое должны целиком лежать внутри родителя
+    extensions::GTAHeader header;
+    if (m_data.size() - m_offset < sizeof(header)) {
+        m_failed = true;
+        return false;
+    }
+    memcpy(&header, m_data.data() + m_offset, sizeof(header));
+    m_offset += sizeof(header);
+    if (header.size > m_data.size() - m_offset) {
+        m_failed = true;
+        return false;
+    }
     
-    bool result = parseFile();
+    chunk.id = header.identifier;
+    chunk.size = header.size;
+    chunk.version = header.fileVersion;
+    chunk.data = m_data.subspan(m_offset, header.size);
+    m_offset += header.size;
+    return true;
+}
+
+bool dff::ChunkWalker::find(uint32_t id, Chunk& chunk) {
+    while (next(chunk)) {
+        if (chunk.id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const uint8_t* dff::ChunkReader::take(size_t count) {
+    if (m_failed || count > m_data.size() - m_offset) {
+        m_failed = true;
+        return nullptr;
+    }
+    const uint8_t* bytes = m_data.data() + m_offset;
+    m_offset += count;
+    return bytes;
+}
+
+bool dff::ChunkReader::skip(size_t count, size_t elementSize) {
+    if (elementSize != 0 && count > (m_data.size() - m_offset) / elementSize) {
+        m_failed = true;
+        return false;
+    }
+    return take(count * elementSize) != nullptr;
+}
+
+dff::DffData::DffData() {
+}
+
+dff::DffData::~DffData() {
+    clear();
+}
+
+bool dff::DffData::loadDffFile(const char* filePath) {
+    printf("[DFF] Загружаем DFF файл: %s\n", filePath);
+    
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        printf("[DFF] Ошибка: Не удалось открыть файл: %s\n", filePath);
+        return false;
+    }
+    
+    std::streamsize fileSize = file.tellg();
+    this->ownedBuffer.resize(static_cast<size_t>(fileSize));
+    this->fileName = filePath;
+    
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(ownedBuffer.data()), fileSize);
+    file.close();
+    
+    printf("[DFF] Файл загружен, размер: %zu байт\n", static_cast<size_t>(fileSize));
+    
+    bool result = parseFile(ownedBuffer);
     if (result) {
         printf("[DFF] Файл успешно распарсен\n");
     } else {
@@ -1075,20 +2252,15 @@ bool dff::DffData::loadDffFile(const char* filePath) {
     return result;
 }
 
-bool dff::DffData::loadDffFromBuffer(const std::vector<uint8_t>& data, const std::string& name) {
+bool dff::DffData::loadDffFromBuffer(std::span<const uint8_t> data, const std::string& name) {
     //printf("[DFF] Загружаем DFF из буфера: %s, размер: %zu байт\n", name.c_str(), data.size());
     
-    this->fileSize = data.size();
-    this->buffer = new char[this->fileSize];
-    this->bufIndex = 0;
-    this->noIssues = true;
+    // Разбираем байты прямо из переданного представления, без копирования;
+    // после разбора ссылок на него не остается
+    this->ownedBuffer.clear();
     this->fileName = name;
     
-    memcpy(buffer, data.data(), fileSize);
-    
-    //printf("[DFF] Буфер загружен, размер: %zu байт\n", fileSize);
-    
-    bool result = parseFile();
+    bool result = parseFile(data);
     if (result) {
         //printf("[DFF] Буфер успешно распарсен\n");
     } else {
@@ -1098,157 +2270,200 @@ bool dff::DffData::loadDffFromBuffer(const std::vector<uint8_t>& data, const std
     return result;
 }
 
-template<typename T>
-T dff::DffData::readBuffer(const unsigned int& inc) {
-    T temp = reinterpret_cast<T>(buffer + bufIndex);
-    bufIndex += inc;
-    return temp;
-}
-
-template<typename T>
-T dff::DffData::readNumeric() {
-    T output;
-    memcpy(&output, buffer + bufIndex, sizeof(T));
-    bufIndex += sizeof(T);
-    return output;
-}
-
-bool dff::DffData::parseFile() {
+bool dff::DffData::parseFile(std::span<const uint8_t> data) {
     //printf("[DFF] Начинаем парсинг файла\n");
     
-    extensions::GTAHeader* leHeader = readBuffer<extensions::GTAHeader*>(sizeof(extensions::GTAHeader));
-    
-    switch(leHeader->getIdentifier()) {
-        case RwTypes::UVANIM_DIC:
-            //printf("[DFF] Пропускаем UVANIM_DIC\n");
-            bufIndex += leHeader->size;
-            return parseFile();
-            
-        case RwTypes::CLUMP_ID:
-            //printf("[DFF] Найдена CLUMP секция\n");
-            return parseClump();
-            
-        default:
-            printf("[DFF] Неизвестная секция: 0x%08X\n", leHeader->identifier);
-        return false;
+    // Верхний уровень: словари UV анимаций пропускаются, первая CLUMP - модель
+    ChunkWalker walker(data);
+    Chunk chunk;
+    while (walker.next(chunk)) {
+        if (!isKnownRwVersion(chunk)) {
+            printf("[DFF] Неизвестная версия RenderWare: 0x%08X\n", chunk.version);
+            return false;
+        }
+        
+        switch (chunk.id) {
+            case RwTypes::UVANIM_DIC:
+                //printf("[DFF] Пропускаем UVANIM_DIC\n");
+                continue;
+                
+            case RwTypes::CLUMP_ID:
+                //printf("[DFF] Найдена CLUMP секция\n");
+                return parseClump(chunk);
+                
+            default:
+                printf("[DFF] Неизвестная секция: 0x%08X\n", chunk.id);
+                return false;
+        }
     }
+    
+    printf("[DFF] CLUMP не найден%s\n", walker.failed() ? " (секция выходит за конец файла)" : "");
+    return false;
 }
 
-bool dff::DffData::parseClump() {
+bool dff::DffData::parseClump(const Chunk& clump) {
     //printf("[DFF] Парсим CLUMP\n");
     
-    extensions::ClumpStruct* leClump = readBuffer<extensions::ClumpStruct*>(sizeof(extensions::ClumpStruct));
-    
-    //printf("[DFF] CLUMP: объектов=%u, источников света=%u, камер=%u\n",   leClump->objectCount, leClump->lightCount, leClump->cameraCount);
-    
-    // Версия GTA III не использует lights и cameras
-    if (leClump->structHeader.fileVersion == GTA_IIIA || 
-        leClump->structHeader.fileVersion == GTA_IIIB || 
-        leClump->structHeader.fileVersion == GTA_IIIC) {
-        //printf("[DFF] GTA III версия, корректируем offset\n");
-        bufIndex -= 8;
+    // Структура CLUMP (число объектов; у GTA III она короче - размер берется из заголовка),
+    // затем FRAME_LIST, GEOMETRY_LIST и атомики, между ними могут быть другие секции
+    ChunkWalker walker(clump.data);
+    Chunk child;
+    if (!walker.next(child) || child.id != RwTypes::STRUCT) {
+        printf("[parseClump] Нет структуры CLUMP\n");
+        return false;
     }
     
-    if (!parseFrameList()) {
+    std::vector<FrameMatrix> worldMatrices;
+    if (!walker.next(child) || child.id != RwTypes::FRAME_LIST || !isKnownRwVersion(child) ||
+        !parseFrameList(child, worldMatrices)) {
         printf("[parseClump] Ошибка парсинга FRAME_LIST\n");
         return false;
     }
     
     // Теперь ищем GEOMETRY_LIST, пропуская возможные промежуточные секции
-    if (!findAndParseGeometryList()) {
-        printf("[parseClump] Ошибка поиска GEOMETRY_LIST\n");
+    std::vector<DffModel> geometries;
+    bool geometryListFound = false;
+    while (!geometryListFound && walker.find(RwTypes::GEOMETRY_LIST, child)) {
+        geometryListFound = isKnownRwVersion(child);
+    }
+    if (!geometryListFound) {
+        printf("[parseClump] Ошибка поиска GEOMETRY_LIST%s\n", walker.failed() ? " (битый заголовок секции)" : "");
         return false;
     }
+    if (!parseGeometryList(child, geometries)) {
+        return false;
+    }
+    
+    // Атомики связывают геометрии с фреймами; битый атомик пропускается
+    std::vector<Atomic> atomics;
+    while (walker.find(RwTypes::ATOMIC, child)) {
+        Atomic atomic;
+        if (parseAtomic(child, atomic) && atomic.geometryIndex < geometries.size() && atomic.frameIndex < worldMatrices.size()) {
+            atomics.push_back(atomic);
+        }
+        else {
+            printf("[parseClump] Пропущен некорректный атомик\n");
+        }
+    }
+    
+    mergeGeometries(geometries, worldMatrices, atomics);
+    model.buildGpuBuffers();
     
     //printf("[DFF] CLUMP успешно распарсен\n");
     return true;
 }
 
+// Единичная матрица фрейма
+static dff::FrameMatrix identityFrameMatrix() {
+    return { { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } } };
+}
 
+// Повернуть вектор (без переноса)
+static void rotateByFrame(const dff::FrameMatrix& m, float x, float y, float z, float out[3]) {
+    for (int axis = 0; axis < 3; axis++) {
+        out[axis] = m.rows[0][axis] * x + m.rows[1][axis] * y + m.rows[2][axis] * z;
+    }
+}
 
-bool dff::DffData::parseFrameList() {
+// Матрица дочернего фрейма в координатах клампа: сначала локальная матрица, затем родительская
+static dff::FrameMatrix combineFrameMatrices(const dff::FrameMatrix& parent, const dff::FrameMatrix& local) {
+    dff::FrameMatrix result;
+    for (int row = 0; row < 3; row++) {
+        rotateByFrame(parent, local.rows[row][0], local.rows[row][1], local.rows[row][2], result.rows[row]);
+    }
+    rotateByFrame(parent, local.rows[3][0], local.rows[3][1], local.rows[3][2], result.rows[3]);
+    for (int axis = 0; axis < 3; axis++) {
+        result.rows[3][axis] += parent.rows[3][axis];
+    }
+    return result;
+}
+
+bool dff::DffData::parseFrameList(const Chunk& frameList, std::vector<FrameMatrix>& worldMatrices) {
     //printf("[DFF] Парсим FRAME_LIST\n");
     
-    extensions::GTAHeader* theHeader = readBuffer<extensions::GTAHeader*>(sizeof(extensions::GTAHeader));
-    if (!(*theHeader == RwTypes::FRAME_LIST)) {
-        printf("[parseFrameList] FRAME_LIST не найден\n");
+    ChunkWalker walker(frameList.data);
+    Chunk listStruct;
+    if (!walker.next(listStruct) || listStruct.id != RwTypes::STRUCT) {
         return false;
     }
     
-    extensions::FrameStructStart* frameInfo = readBuffer<extensions::FrameStructStart*>(sizeof(extensions::FrameStructStart));
-    //printf("[DFF] Количество фреймов: %u\n", frameInfo->frameCount);
-    
-    // Пропускаем данные фреймов
-    bufIndex += sizeof(extensions::GTAFrame) * frameInfo->frameCount;
+    ChunkReader reader(listStruct.data);
+    uint32_t frameCount = 0;
+    if (!reader.read(frameCount) || frameCount > reader.remaining() / sizeof(extensions::GTAFrame)) {
+        return false;
+    }
+    //printf("[DFF] Количество фреймов: %u\n", frameCount);
+    
+    std::vector<FrameMatrix> localMatrices(frameCount);
+    std::vector<uint32_t> parents(frameCount);
+    for (uint32_t i = 0; i < frameCount; i++) {
+        extensions::GTAFrame frame;
+        reader.read(frame);
+        memcpy(localMatrices[i].rows, frame.transMatrix, sizeof(localMatrices[i].rows));
+        parents[i] = frame.parent;
+    }
+    
+    // Матрицы в координатах клампа. Родитель обычно идет раньше ребенка, но порядок не гарантирован:
+    // цепочка поднимается до уже посчитанного фрейма; цикл обрывается на числе фреймов
+    worldMatrices.assign(frameCount, identityFrameMatrix());
+    std::vector<uint8_t> resolved(frameCount, 0);
+    std::vector<uint32_t> chain;
+    for (uint32_t i = 0; i < frameCount; i++) {
+        chain.clear();
+        uint32_t current = i;
+        while (current < frameCount && !resolved[current] && chain.size() <= frameCount) {
+            chain.push_back(current);
+            current = parents[current];
+        }
+        
+        FrameMatrix base = (current < frameCount && resolved[current]) ? worldMatrices[current] : identityFrameMatrix();
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            if (resolved[*it]) {
+                base = worldMatrices[*it];
+                continue;
+            }
+            base = combineFrameMatrices(base, localMatrices[*it]);
+            worldMatrices[*it] = base;
+            resolved[*it] = 1;
+        }
+    }
     
     //printf("[DFF] FRAME_LIST успешно распарсен\n");
     return true;
 }
 
-bool dff::DffData::findAndParseGeometryList() {
-    //printf("[DFF] Ищем GEOMETRY_LIST секцию...\n");
-    
-    // Читаем секции до тех пор, пока не найдем GEOMETRY_LIST
-    while (bufIndex < fileSize) {
-        if (bufIndex + sizeof(extensions::GTAHeader) > fileSize) {
-            printf("[findAndParseGeometryList] Достигнут конец файла, GEOMETRY_LIST не найден\n");
-                    return false;
-                }
-        
-        extensions::GTAHeader* sectionHeader = readBuffer<extensions::GTAHeader*>(sizeof(extensions::GTAHeader));
-        //printf("[DFF] Найдена секция: 0x%08X, размер: %u, версия: 0x%08X\n",  sectionHeader->identifier, sectionHeader->size, sectionHeader->fileVersion);
-        
-        switch (sectionHeader->getIdentifier()) {
-            case RwTypes::GEOMETRY_LIST:
-                //printf("[DFF] Найден GEOMETRY_LIST! Парсим...\n");
-                return parseGeometryList();
-                
-            case RwTypes::EXTENSION:
-                //printf("[DFF] Пропускаем EXTENSION секцию\n");
-                bufIndex += sectionHeader->size;
-                break;
-                
-            case RwTypes::STRUCT:
-                //printf("[DFF] Пропускаем STRUCT секцию\n");
-                bufIndex += sectionHeader->size;
-                break;
-                
-            case RwTypes::ATOMIC:
-                //printf("[DFF] Пропускаем ATOMIC секцию\n");
-                bufIndex += sectionHeader->size;
-                break;
-                
-            case RwTypes::LIGHT:
-                //printf("[DFF] Пропускаем LIGHT секцию\n");
-                bufIndex += sectionHeader->size;
-                break;
-                
-            case RwTypes::CAMERA:
-                //printf("[DFF] Пропускаем CAMERA секцию\n");
-                bufIndex += sectionHeader->size;
-                break;
-                
-            default:
-                printf("[DFF] Неизвестная секция 0x%08X, пропускаем %u байт\n",   sectionHeader->identifier, sectionHeader->size);
-                bufIndex += sectionHeader->size;
-                break;
-        }
-    }
-    
-    printf("[DFF] GEOMETRY_LIST не найден после перебора всех секций\n");
+bool dff::DffData::parseAtomic(const Chunk& atomic, Atomic& result) {
+    ChunkWalker walker(atomic.data);
+    Chunk atomicStruct;
+    if (!walker.next(atomicStruct) || atomicStruct.id != RwTypes::STRUCT) {
         return false;
     }
     
-bool dff::DffData::parseGeometryList() {
+    ChunkReader reader(atomicStruct.data);
+    return reader.read(result.frameIndex) && reader.read(result.geometryIndex);
+}
+
+bool dff::DffData::parseGeometryList(const Chunk& geometryList, std::vector<DffModel>& geometries) {
     //printf("[DFF] Парсим GEOMETRY_LIST\n");
     
-    // Мы уже прочитали заголовок в findAndParseGeometryList, 
-    // поэтому сразу читаем структуру GeoListStruct
-    extensions::GeoListStruct* gListStruct = readBuffer<extensions::GeoListStruct*>(sizeof(extensions::GeoListStruct));
-    //printf("[DFF] Количество геометрий: %u\n", gListStruct->gCount);
+    ChunkWalker walker(geometryList.data);
+    Chunk child;
+    uint32_t geometryCount = 0;
+    if (!walker.next(child) || child.id != RwTypes::STRUCT || !ChunkReader(child.data).read(geometryCount)) {
+        printf("[parseGeometryList] Нет структуры GEOMETRY_LIST\n");
+        return false;
+    }
+    //printf("[DFF] Количество геометрий: %u\n", geometryCount);
+    
+    // Каждая геометрия - минимум заголовок; больше геометрий в секции не поместится
+    if (geometryCount > geometryList.data.size() / sizeof(extensions::GTAHeader)) {
+        printf("[parseGeometryList] Некорректное число геометрий: %u\n", geometryCount);
+        return false;
+    }
     
-    for (uint32_t idx = 0; idx < gListStruct->gCount; idx++) {
-        if (!parseGeometry(idx)) {
+    geometries.resize(geometryCount);
+    for (uint32_t idx = 0; idx < geometryCount; idx++) {
+        if (!walker.next(child) || !parseGeometry(child, idx, geometries[idx])) {
             printf("[parseGeometryList] Ошибка парсинга геометрии %u\n", idx);
             return false;
         }
@@ -1258,137 +2473,476 @@ bool dff::DffData::parseGeometryList() {
     return true;
 }
 
-bool dff::DffData::parseGeometry(const uint32_t& gIndex) {
-    //printf("[DFF] Парсим геометрию %u\n", gIndex);
+// Моделируемый кэш вершин после трансформации: LRU для оценки Форсайта, FIFO для подсчета ACMR
+static const uint32_t kVertexCacheSize = 32;
+
+// Параметры оценки вершин из алгоритма Тома Форсайта (Linear-Speed Vertex Cache Optimisation)
+static const float kCacheDecayPower = 1.5f;
+static const float kLastTriangleScore = 0.75f;
+static const float kValenceBoostScale = 2.0f;
+static const float kValenceBoostPower = 0.5f;
+
+// Промахи FIFO кэша вершин при отрисовке треугольников в данном порядке
+static uint32_t countVertexCacheMisses(const std::vector<dff::Polygon>& polygons, uint32_t vertexCount) {
+    // Каждый промах вставляет одну вершину, поэтому номер промаха служит временем вставки:
+    // вершина еще в кэше, если после нее было меньше kVertexCacheSize вставок
+    std::vector<uint32_t> insertedAt(vertexCount, UINT32_MAX);
+    uint32_t misses = 0;
+    for (const auto& poly : polygons) {
+        for (uint32_t index : { poly.vertex1, poly.vertex2, poly.vertex3 }) {
+            if (insertedAt[index] == UINT32_MAX || misses - insertedAt[index] >= kVertexCacheSize) {
+                insertedAt[index] = misses++;
+            }
+        }
+    }
+    return misses;
+}
+
+// Оценка вершины: недавние вершины в кэше и вершины с малым числом оставшихся треугольников - выше
+static float forsythVertexScore(int cachePosition, uint32_t remainingTriangles) {
+    if (remainingTriangles == 0) {
+        return -1.0f;
+    }
     
-    extensions::GTAHeader* theHeader = readBuffer<extensions::GTAHeader*>(sizeof(extensions::GTAHeader));
-    if (theHeader->identifier != RwTypes::GEOMETRY) {
-        printf("[parseGeometry] Ожидается GEOMETRY, получено: 0x%08X\n", theHeader->identifier);
-            return false;
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // Вершины только что нарисованного треугольника
+            score = kLastTriangleScore;
         }
-        
-    extensions::GeoParams* meshParams = readBuffer<extensions::GeoParams*>(sizeof(extensions::GeoParams));
-    //printf("[DFF] Геометрия: флаги=0x%02X, UV=%u, граней=%u, вершин=%u\n",   meshParams->flags, meshParams->numUVs, meshParams->faceCount, meshParams->vertexCount);
+        else {
+            const float scale = 1.0f / (kVertexCacheSize - 3);
+            score = powf(1.0f - (cachePosition - 3) * scale, kCacheDecayPower);
+        }
+    }
+    return score + kValenceBoostScale * powf(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+}
+
+// Переупорядочить треугольники под кэш вершин (жадный алгоритм Форсайта): на каждом шаге
+// рисуется треугольник с наибольшей суммой оценок вершин; кандидаты - соседи вершин из кэша
+static void optimizeVertexCache(std::vector<dff::Polygon>& polygons, uint32_t vertexCount) {
+    const uint32_t triangleCount = static_cast<uint32_t>(polygons.size());
+    if (triangleCount < 2) {
+        return;
+    }
+    
+    // Треугольники каждой вершины; активные (еще не нарисованные) лежат в начале ее диапазона
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (const auto& poly : polygons) {
+        remaining[poly.vertex1]++;
+        remaining[poly.vertex2]++;
+        remaining[poly.vertex3]++;
+    }
+    std::vector<uint32_t> adjacencyStart(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        adjacencyStart[v + 1] = adjacencyStart[v] + remaining[v];
+    }
+    std::vector<uint32_t> adjacency(static_cast<size_t>(triangleCount) * 3);
+    {
+        std::vector<uint32_t> cursor(adjacencyStart.begin(), adjacencyStart.end() - 1);
+        for (uint32_t t = 0; t < triangleCount; t++) {
+            adjacency[cursor[polygons[t].vertex1]++] = t;
+            adjacency[cursor[polygons[t].vertex2]++] = t;
+            adjacency[cursor[polygons[t].vertex3]++] = t;
+        }
+    }
     
-    // Пропускаем ambient/specular/diffuse для старых версий
-    if (meshParams->structHeader.fileVersion == GTA_IIIA || 
-        meshParams->structHeader.fileVersion == GTA_IIIB || 
-        meshParams->structHeader.fileVersion == GTA_IIIC || 
-        meshParams->structHeader.fileVersion == GTA_VCA) {
-        bufIndex += 12; // 3 * sizeof(float)
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++) {
+        vertexScore[v] = forsythVertexScore(-1, remaining[v]);
     }
     
-    // Читаем цвета вершин если есть
-    if (meshParams->flags & 8) { // PRELIT
-        //printf("[DFF] Читаем цвета вершин\n");
-        bufIndex += meshParams->vertexCount * 4; // sizeof(VertexColors)
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    uint32_t bestTriangle = 0;
+    for (uint32_t t = 0; t < triangleCount; t++) {
+        const dff::Polygon& poly = polygons[t];
+        triangleScore[t] = vertexScore[poly.vertex1] + vertexScore[poly.vertex2] + vertexScore[poly.vertex3];
+        if (triangleScore[t] > triangleScore[bestTriangle]) {
+            bestTriangle = t;
+        }
     }
     
-    // Читаем UV координаты если есть
-    if (meshParams->numUVs > 0) {
-        //printf("[DFF] Читаем UV координаты\n");
-        bufIndex += meshParams->numUVs * meshParams->vertexCount * sizeof(extensions::UVData);
+    std::vector<dff::Polygon> ordered;
+    ordered.reserve(triangleCount);
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(kVertexCacheSize + 3);
+    nextCache.reserve(kVertexCacheSize + 3);
+    uint32_t scanCursor = 0;
+    
+    while (ordered.size() < triangleCount) {
+        if (bestTriangle == UINT32_MAX) {
+            // У вершин в кэше не осталось треугольников - берем первый ненарисованный
+            while (emitted[scanCursor]) {
+                scanCursor++;
+            }
+            bestTriangle = scanCursor;
+        }
+        
+        const dff::Polygon triangle = polygons[bestTriangle];
+        emitted[bestTriangle] = 1;
+        ordered.push_back(triangle);
+        
+        // Убираем треугольник из активных у его вершин
+        const uint32_t corners[3] = { triangle.vertex1, triangle.vertex2, triangle.vertex3 };
+        for (uint32_t v : corners) {
+            uint32_t* begin = adjacency.data() + adjacencyStart[v];
+            uint32_t* end = begin + remaining[v];
+            uint32_t* it = std::find(begin, end, bestTriangle);
+            if (it != end) {
+                std::swap(*it, *(end - 1));
+                remaining[v]--;
+            }
+        }
+        
+        // LRU: вершины треугольника - в начало кэша, остальные сдвигаются
+        nextCache.clear();
+        for (uint32_t v : corners) {
+            if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+                nextCache.push_back(v);
+            }
+        }
+        for (uint32_t v : cache) {
+            if (v != corners[0] && v != corners[1] && v != corners[2]) {
+                nextCache.push_back(v);
+            }
+        }
+        
+        // Пересчитываем оценки вершин кэша (и вытесненных) и переносим разницу на их треугольники
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            const uint32_t v = nextCache[i];
+            cachePosition[v] = i < kVertexCacheSize ? static_cast<int>(i) : -1;
+            const float score = forsythVertexScore(cachePosition[v], remaining[v]);
+            const float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                triangleScore[adjacency[adjacencyStart[v] + j]] += delta;
+            }
+        }
+        if (nextCache.size() > kVertexCacheSize) {
+            nextCache.resize(kVertexCacheSize);
+        }
+        cache.swap(nextCache);
+        
+        // Следующий треугольник - лучший среди соседей вершин кэша
+        bestTriangle = UINT32_MAX;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                const uint32_t t = adjacency[adjacencyStart[v] + j];
+                if (triangleScore[t] > bestScore) {
+                    bestScore = triangleScore[t];
+                    bestTriangle = t;
+                }
+            }
+        }
     }
     
-    // Читаем информацию о гранях
-    //printf("[DFF] Читаем информацию о гранях\n");
-    extensions::FaceBAFC* faceInfo = readBuffer<extensions::FaceBAFC*>(sizeof(extensions::FaceBAFC) * meshParams->faceCount);
+    polygons.swap(ordered);
+}
+
+bool dff::DffData::parseGeometry(const Chunk& geometry, uint32_t gIndex, DffModel& geometryModel) {
+    //printf("[DFF] Парсим геометрию %u\n", gIndex);
     
-    // Сохраняем полигоны
-    model.polygons.clear();
-    model.polygons.reserve(meshParams->faceCount);
+    if (geometry.id != RwTypes::GEOMETRY) {
+        printf("[parseGeometry] Ожидается GEOMETRY, получено: 0x%08X\n", geometry.id);
+        return false;
+    }
     
-    for (uint32_t i = 0; i < meshParams->faceCount; i++) {
-        dff::Polygon polygon;
-        polygon.vertex1 = faceInfo[i].aDat;
-        polygon.vertex2 = faceInfo[i].bDat;
-        polygon.vertex3 = faceInfo[i].cDat;
-        polygon.materialId = faceInfo[i].fDat;
-        model.polygons.push_back(polygon);
+    ChunkWalker walker(geometry.data);
+    Chunk geometryStruct;
+    if (!walker.next(geometryStruct) || geometryStruct.id != RwTypes::STRUCT) {
+        printf("[parseGeometry] Нет структуры геометрии %u\n", gIndex);
+        return false;
     }
     
-    // Пропускаем bounding information (24 байта)
-    bufIndex += 24;
+    // Все количества проверяются по размеру структуры до выделения памяти
+    ChunkReader reader(geometryStruct.data);
+    uint8_t flags = 0, unused1 = 0, numUVs = 0, nativeFlags = 0;
+    uint32_t faceCount = 0, vertexCount = 0, frameCount = 0;
+    reader.read(flags);
+    reader.read(unused1);
+    reader.read(numUVs);
+    reader.read(nativeFlags);
+    reader.read(faceCount);
+    reader.read(vertexCount);
+    reader.read(frameCount);
+    //printf("[DFF] Геометрия: флаги=0x%02X, UV=%u, граней=%u, вершин=%u\n", flags, numUVs, faceCount, vertexCount);
     
-    // Читаем вершины
-    //printf("[DFF] Читаем вершины\n");
-    extensions::Vector3* vertexList = readBuffer<extensions::Vector3*>(sizeof(extensions::Vector3) * meshParams->vertexCount);
+    // Пропускаем ambient/specular/diffuse для старых версий
+    if (geometryStruct.version == GTA_IIIA || geometryStruct.version == GTA_IIIB ||
+        geometryStruct.version == GTA_IIIC || geometryStruct.version == GTA_VCA) {
+        reader.skip(3, sizeof(float));
+    }
     
-    model.vertices.clear();
-    model.vertices.reserve(meshParams->vertexCount);
+    // Цвета вершин и UV координаты пока не используются
+    if (flags & 8) { // PRELIT
+        reader.skip(vertexCount, sizeof(extensions::VertexColors));
+    }
+    if (numUVs > 0) {
+        reader.skip(static_cast<size_t>(numUVs) * vertexCount, sizeof(extensions::UVData));
+    }
+    
+    // Грани
+    const uint8_t* faceData = reader.take(static_cast<size_t>(faceCount) * sizeof(extensions::FaceBAFC));
     
-    for (uint32_t i = 0; i < meshParams->vertexCount; i++) {
-        dff::Vertex vertex;
-        vertex.x = vertexList[i].x;
-        vertex.y = vertexList[i].y;
-        vertex.z = vertexList[i].z;
-        model.vertices.push_back(vertex);
+    // Пропускаем bounding information (24 байта)
+    reader.skip(24);
+    
+    // Вершины и нормали
+    const uint8_t* vertexData = reader.take(static_cast<size_t>(vertexCount) * sizeof(extensions::Vector3));
+    const uint8_t* normalData = (flags & 16) ? reader.take(static_cast<size_t>(vertexCount) * sizeof(extensions::Vector3)) : nullptr;
+    if (reader.failed()) {
+        printf("[parseGeometry] Геометрия %u выходит за границы своей секции\n", gIndex);
+        return false;
     }
     
-    // Читаем нормали если есть
-    if (meshParams->flags & 16) { // NORMS
-        //printf("[DFF] Читаем нормали\n");
-        extensions::Vector3* normalList = readBuffer<extensions::Vector3*>(sizeof(extensions::Vector3) * meshParams->vertexCount);
-        
-        model.normals.clear();
-        model.normals.reserve(meshParams->vertexCount);
-        
-        for (uint32_t i = 0; i < meshParams->vertexCount; i++) {
-            dff::Normal normal;
-            normal.x = normalList[i].x;
-            normal.y = normalList[i].y;
-            normal.z = normalList[i].z;
-            model.normals.push_back(normal);
+    // Индексы граней должны ссылаться на существующие вершины
+    geometryModel.polygons.clear();
+    geometryModel.polygons.reserve(faceCount);
+    for (uint32_t i = 0; i < faceCount; i++) {
+        extensions::FaceBAFC face;
+        memcpy(&face, faceData + i * sizeof(face), sizeof(face));
+        if (face.aDat >= vertexCount || face.bDat >= vertexCount || face.cDat >= vertexCount) {
+            printf("[parseGeometry] Грань %u ссылается на несуществующую вершину\n", i);
+            return false;
         }
+        geometryModel.polygons.emplace_back(face.aDat, face.bDat, face.cDat, face.fDat);
+    }
+    
+    static_assert(sizeof(dff::Vertex) == sizeof(extensions::Vector3) && sizeof(dff::Normal) == sizeof(extensions::Vector3),
+                  "Вершины и нормали копируются из файла целиком");
+    geometryModel.vertices.resize(vertexCount);
+    memcpy(geometryModel.vertices.data(), vertexData, static_cast<size_t>(vertexCount) * sizeof(extensions::Vector3));
+    if (normalData) {
+        geometryModel.normals.resize(vertexCount);
+        memcpy(geometryModel.normals.data(), normalData, static_cast<size_t>(vertexCount) * sizeof(extensions::Vector3));
     }
     
-    // Парсим список материалов
-    if (!parseMaterialList(gIndex)) {
+    // Список материалов идет сразу после структуры геометрии
+    Chunk materialList;
+    if (!walker.next(materialList) || !parseMaterialList(materialList, gIndex, geometryModel)) {
         printf("[parseGeometry] Ошибка парсинга списка материалов\n");
         return false;
     }
     
-    //printf("[DFF] Геометрия %u успешно распарсена: %zu вершин, %zu граней\n",  gIndex, model.vertices.size(), model.polygons.size());
-    
-    return true;
-}
-
-bool dff::DffData::parseMaterialList(const uint32_t& geoIndex) {
-    //printf("[DFF] Парсим список материалов\n");
-    
-    extensions::GTAHeader* leHeader = readBuffer<extensions::GTAHeader*>(sizeof(extensions::GTAHeader));
-    if (leHeader->getIdentifier() != RwTypes::MATERIAL_LIST) {
-        //printf("[parseMaterialList] MATERIAL_LIST не найден\n");
-                return false; 
+    // Без списка граней в структуре треугольники берутся из BIN_MESH_PLG в расширении геометрии
+    // (у нативной геометрии индексов в нем нет)
+    Chunk extension;
+    if (geometryModel.polygons.empty() && !(nativeFlags & 1) && walker.find(RwTypes::EXTENSION, extension)) {
+        ChunkWalker extensionWalker(extension.data);
+        Chunk binMesh;
+        if (extensionWalker.find(RwTypes::BIN_MESH_PLG, binMesh)) {
+            std::vector<Polygon> meshPolygons;
+            if (parseBinMesh(binMesh, vertexCount, meshPolygons)) {
+                geometryModel.polygons = std::move(meshPolygons);
             }
+        }
+    }
     
-    extensions::FrameStructStart* materialListStruct = readBuffer<extensions::FrameStructStart*>(sizeof(extensions::FrameStructStart));
-    //printf("[DFF] Количество материалов: %u\n", materialListStruct->frameCount);
+    // Порядок треугольников под кэш вершин GPU; промахи до и после сохраняются в модели
+    geometryModel.cacheMissesBefore = countVertexCacheMisses(geometryModel.polygons, vertexCount);
+    optimizeVertexCache(geometryModel.polygons, vertexCount);
+    geometryModel.cacheMissesAfter = countVertexCacheMisses(geometryModel.polygons, vertexCount);
     
-    // Пропускаем данные материалов пока
-    bufIndex += materialListStruct->frameCount * 4;
+    //printf("[DFF] Геометрия %u успешно распарсена: %zu вершин, %zu граней\n", gIndex, geometryModel.vertices.size(), geometryModel.polygons.size());
     
-    //printf("[DFF] Список материалов успешно распарсен\n");
     return true;
 }
 
-bool dff::DffData::parseMaterial(const uint32_t& matID) {
-    // Пока не реализовано
+bool dff::DffData::parseBinMesh(const Chunk& binMesh, uint32_t vertexCount, std::vector<Polygon>& polygons) {
+    // Заголовок: тип (0 - списки треугольников, 1 - полосы), число мешей и всего индексов;
+    // затем у каждого меша число индексов, материал и сами индексы (uint32)
+    ChunkReader reader(binMesh.data);
+    uint32_t isTriStrip = 0, meshCount = 0, totalIndexCount = 0;
+    reader.read(isTriStrip);
+    reader.read(meshCount);
+    reader.read(totalIndexCount);
+    if (reader.failed()) {
+        printf("[parseBinMesh] Нет заголовка BIN_MESH_PLG\n");
+        return false;
+    }
+    
+    polygons.clear();
+    // Счетчик из заголовка не доверенный: индексов не может быть больше, чем помещается в секции
+    const size_t indexCapacity = std::min<size_t>(totalIndexCount, reader.remaining() / sizeof(uint32_t));
+    polygons.reserve(isTriStrip ? indexCapacity : indexCapacity / 3);
+    for (uint32_t mesh = 0; mesh < meshCount; mesh++) {
+        uint32_t indexCount = 0, materialId = 0;
+        reader.read(indexCount);
+        reader.read(materialId);
+        const uint8_t* indexData = reader.take(static_cast<size_t>(indexCount) * sizeof(uint32_t));
+        if (reader.failed()) {
+            printf("[parseBinMesh] Меш %u выходит за границы секции\n", mesh);
+            return false;
+        }
+        
+        // Индексы читаются прямо из секции, без промежуточной копии
+        auto indexAt = [indexData](uint32_t i) {
+            uint32_t index;
+            memcpy(&index, indexData + static_cast<size_t>(i) * sizeof(uint32_t), sizeof(uint32_t));
+            return index;
+        };
+        for (uint32_t i = 0; i < indexCount; i++) {
+            if (indexAt(i) >= vertexCount) {
+                printf("[parseBinMesh] Меш %u ссылается на несуществующую вершину\n", mesh);
+                return false;
+            }
+        }
+        
+        if (isTriStrip) {
+            // Полоса: каждый следующий индекс образует треугольник с двумя предыдущими, у нечетных
+            // треугольников обход меняется; вырожденные треугольники-связки пропускаются
+            for (uint32_t i = 2; i < indexCount; i++) {
+                uint32_t a = indexAt(i - 2), b = indexAt(i - 1), c = indexAt(i);
+                if (a == b || b == c || a == c) {
+                    continue;
+                }
+                if (i & 1) {
+                    std::swap(a, b);
+                }
+                polygons.emplace_back(a, b, c, materialId);
+            }
+        }
+        else {
+            for (uint32_t i = 0; i + 2 < indexCount; i += 3) {
+                polygons.emplace_back(indexAt(i), indexAt(i + 1), indexAt(i + 2), materialId);
+            }
+        }
+    }
+    
     return true;
 }
 
-bool dff::DffData::parseTexture() {
-    // Пока не реализовано
-    return true;
+// Нормали вершин как среднее нормалей прилегающих граней (для геометрии без своих нормалей)
+static void computeVertexNormals(const dff::DffModel& geometry, std::vector<dff::Normal>& normals) {
+    normals.assign(geometry.vertices.size(), dff::Normal(0.0f, 0.0f, 0.0f));
+    for (const auto& poly : geometry.polygons) {
+        const dff::Vertex& v1 = geometry.vertices[poly.vertex1];
+        const dff::Vertex& v2 = geometry.vertices[poly.vertex2];
+        const dff::Vertex& v3 = geometry.vertices[poly.vertex3];
+        float e1x = v2.x - v1.x, e1y = v2.y - v1.y, e1z = v2.z - v1.z;
+        float e2x = v3.x - v1.x, e2y = v3.y - v1.y, e2z = v3.z - v1.z;
+        float nx = e1y * e2z - e1z * e2y;
+        float ny = e1z * e2x - e1x * e2z;
+        float nz = e1x * e2y - e1y * e2x;
+        for (uint32_t index : { poly.vertex1, poly.vertex2, poly.vertex3 }) {
+            normals[index].x += nx;
+            normals[index].y += ny;
+            normals[index].z += nz;
+        }
+    }
 }
 
-bool dff::DffData::parseBinMesh() {
-    // Пока не реализовано
-    return true;
+void dff::DffData::mergeGeometries(std::vector<DffModel>& geometries, const std::vector<FrameMatrix>& worldMatrices,
+                                   const std::vector<Atomic>& atomics) {
+    // Без атомиков (например, модель только из GEOMETRY_LIST) берем все геометрии как есть
+    std::vector<Atomic> parts = atomics;
+    if (parts.empty()) {
+        for (uint32_t i = 0; i < geometries.size(); i++) {
+            parts.push_back({ GeometryRange::kNoFrame, i });
+        }
+    }
+    
+    size_t totalVertices = 0, totalPolygons = 0;
+    bool anyNormals = false;
+    for (const auto& part : parts) {
+        totalVertices += geometries[part.geometryIndex].vertices.size();
+        totalPolygons += geometries[part.geometryIndex].polygons.size();
+        anyNormals = anyNormals || !geometries[part.geometryIndex].normals.empty();
+    }
+    
+    model.vertices.clear();
+    model.normals.clear();
+    model.polygons.clear();
+    model.materials.clear();
+    model.geometryRanges.clear();
+    model.cacheMissesBefore = 0;
+    model.cacheMissesAfter = 0;
+    model.vertices.reserve(totalVertices);
+    model.normals.reserve(anyNormals ? totalVertices : 0);
+    model.polygons.reserve(totalPolygons);
+    model.geometryRanges.reserve(parts.size());
+    
+    std::vector<Normal> generatedNormals;
+    for (const auto& part : parts) {
+        const DffModel& geometry = geometries[part.geometryIndex];
+        const FrameMatrix matrix = part.frameIndex < worldMatrices.size() ? worldMatrices[part.frameIndex] : identityFrameMatrix();
+        
+        GeometryRange range;
+        range.geometryIndex = part.geometryIndex;
+        range.frameIndex = part.frameIndex;
+        range.firstVertex = static_cast<uint32_t>(model.vertices.size());
+        range.vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+        range.firstPolygon = static_cast<uint32_t>(model.polygons.size());
+        range.polygonCount = static_cast<uint32_t>(geometry.polygons.size());
+        model.geometryRanges.push_back(range);
+        model.cacheMissesBefore += geometry.cacheMissesBefore;
+        model.cacheMissesAfter += geometry.cacheMissesAfter;
+        
+        for (const auto& vertex : geometry.vertices) {
+            float position[3];
+            rotateByFrame(matrix, vertex.x, vertex.y, vertex.z, position);
+            model.vertices.emplace_back(position[0] + matrix.rows[3][0], position[1] + matrix.rows[3][1], position[2] + matrix.rows[3][2]);
+        }
+        
+        // Если нормали есть хотя бы у одной части, недостающие достраиваются, чтобы массивы совпали
+        if (anyNormals) {
+            const std::vector<Normal>* normals = &geometry.normals;
+            if (normals->empty()) {
+                computeVertexNormals(geometry, generatedNormals);
+                normals = &generatedNormals;
+            }
+            for (const auto& normal : *normals) {
+                float rotated[3];
+                rotateByFrame(matrix, normal.x, normal.y, normal.z, rotated);
+                float length = sqrtf(rotated[0] * rotated[0] + rotated[1] * rotated[1] + rotated[2] * rotated[2]);
+                if (length > 0.0001f) {
+                    rotated[0] /= length;
+                    rotated[1] /= length;
+                    rotated[2] /= length;
+                }
+                model.normals.emplace_back(rotated[0], rotated[1], rotated[2]);
+            }
+        }
+        
+        // Материалы частей идут подряд: номер материала грани сдвигается на материалы предыдущих частей
+        const uint32_t firstMaterial = static_cast<uint32_t>(model.materials.size());
+        model.materials.insert(model.materials.end(), geometry.materials.begin(), geometry.materials.end());
+        for (const auto& poly : geometry.polygons) {
+            model.polygons.emplace_back(poly.vertex1 + range.firstVertex, poly.vertex2 + range.firstVertex,
+                                        poly.vertex3 + range.firstVertex, poly.materialId + firstMaterial);
+        }
+    }
 }
 
-bool dff::DffData::parseExtension() {
-    // Пока не реализовано
+bool dff::DffData::parseMaterialList(const Chunk& materialList, uint32_t geoIndex, DffModel& geometryModel) {
+    //printf("[DFF] Парсим список материалов\n");
+    
+    if (materialList.id != RwTypes::MATERIAL_LIST || !isKnownRwVersion(materialList)) {
+        //printf("[parseMaterialList] MATERIAL_LIST не найден\n");
+        return false;
+    }
+    
+    // Свойства материалов пока не разбираются - нужно только их количество (по нему номера
+    // материалов граней сдвигаются при объединении геометрий)
+    ChunkWalker walker(materialList.data);
+    Chunk listStruct;
+    uint32_t materialCount = 0;
+    if (!walker.next(listStruct) || listStruct.id != RwTypes::STRUCT) {
+        return false;
+    }
+    ChunkReader reader(listStruct.data);
+    reader.read(materialCount);
+    reader.skip(materialCount, sizeof(int32_t));
+    if (reader.failed()) {
+        return false;
+    }
+    //printf("[DFF] Количество материалов: %u\n", materialCount);
+    
+    geometryModel.materials.clear();
+    geometryModel.materials.resize(materialCount);
     return true;
 }
 
@@ -1400,227 +2954,184 @@ void dff::DffData::clear() {
     fileName.clear();
     model.clear();
     
-    if (buffer) {
-        delete[] buffer;
-        buffer = nullptr;
-    }
-    bufIndex = 0;
-    fileSize = 0;
-    noIssues = true;
+    ownedBuffer.clear();
 }
 
 // ============================================================================
 // DffModel IMPLEMENTATION
 // ============================================================================
 
-bool dff::DffModel::loadToGPU() {
-    //printf("[DFF] Загружаем модель в GPU: %zu вершин, %zu полигонов\n", vertices.size(), polygons.size());
-    
-    // Проверяем, что OpenGL контекст активен
-    GLint currentVAO;
-    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &currentVAO);
-    //printf("[loadToGPU] Текущий VAO: %d\n", currentVAO);
+// Октаэдрическая упаковка единичной нормали в два snorm16: проекция на октаэдр |x|+|y|+|z|=1,
+// нижняя полусфера отражается на углы квадрата. Распаковка - в вершинном шейдере моделей
+static void packOctahedralNormal(float nx, float ny, float nz, int16_t packed[2]) {
+    float sum = fabsf(nx) + fabsf(ny) + fabsf(nz);
+    if (sum < 0.0001f) {
+        // Вырожденная нормаль (например, у вырожденного треугольника) - смотрит вверх
+        packed[0] = 0;
+        packed[1] = 0;
+        return;
+    }
+    float u = nx / sum;
+    float v = ny / sum;
+    if (nz < 0.0f) {
+        float foldedU = (1.0f - fabsf(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+        float foldedV = (1.0f - fabsf(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+        u = foldedU;
+        v = foldedV;
+    }
+    packed[0] = static_cast<int16_t>(lroundf(std::clamp(u, -1.0f, 1.0f) * 32767.0f));
+    packed[1] = static_cast<int16_t>(lroundf(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+void dff::DffModel::buildGpuBuffers() {
+    gpuVertices.clear();
+    gpuIndices.clear();
+    gpuIndexCount = 0;
+    gpuIndexSize = 0;
+    if (vertices.empty() || polygons.empty()) {
+        return;
+    }
+    
+    // Модели без своих нормалей получают средние нормали граней
+    std::vector<Normal> generatedNormals;
+    const std::vector<Normal>* sourceNormals = &normals;
+    if (normals.size() != vertices.size()) {
+        computeVertexNormals(*this, generatedNormals);
+        sourceNormals = &generatedNormals;
+    }
+    
+    gpuVertices.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); i++) {
+        GpuVertex& gpuVertex = gpuVertices[i];
+        gpuVertex.x = vertices[i].x;
+        gpuVertex.y = vertices[i].y;
+        gpuVertex.z = vertices[i].z;
+        const Normal& normal = (*sourceNormals)[i];
+        packOctahedralNormal(normal.x, normal.y, normal.z, gpuVertex.normal);
+    }
+    
+    // Индексы в самом узком типе, которым адресуются все вершины
+    gpuIndexCount = static_cast<uint32_t>(polygons.size() * 3);
+    gpuIndexSize = vertices.size() < 65536 ? sizeof(uint16_t) : sizeof(uint32_t);
+    gpuIndices.resize(static_cast<size_t>(gpuIndexCount) * gpuIndexSize);
+    if (gpuIndexSize == sizeof(uint16_t)) {
+        uint16_t* indices = reinterpret_cast<uint16_t*>(gpuIndices.data());
+        for (const auto& poly : polygons) {
+            *indices++ = static_cast<uint16_t>(poly.vertex1);
+            *indices++ = static_cast<uint16_t>(poly.vertex2);
+            *indices++ = static_cast<uint16_t>(poly.vertex3);
+        }
+    }
+    else {
+        uint32_t* indices = reinterpret_cast<uint32_t*>(gpuIndices.data());
+        for (const auto& poly : polygons) {
+            *indices++ = poly.vertex1;
+            *indices++ = poly.vertex2;
+            *indices++ = poly.vertex3;
+        }
+    }
     
+    // Геометрия теперь живет только в упакованных буферах
+    vertices.clear();
+    vertices.shrink_to_fit();
+    normals.clear();
+    normals.shrink_to_fit();
+    polygons.clear();
+    polygons.shrink_to_fit();
+}
+
+uint32_t dff::DffModel::getGpuIndex(size_t i) const {
+    if (gpuIndexSize == sizeof(uint16_t)) {
+        uint16_t index;
+        memcpy(&index, gpuIndices.data() + i * sizeof(uint16_t), sizeof(uint16_t));
+        return index;
+    }
+    uint32_t index;
+    memcpy(&index, gpuIndices.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+    return index;
+}
+
+uint32_t dff::DffModel::getGpuIndexType() const {
+    return gpuIndexSize == sizeof(uint16_t) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+bool dff::DffModel::createGpuBuffers(uint32_t& outVao, uint32_t& outVbo, uint32_t& outEbo) const {
     // Проверяем, что у нас есть данные для загрузки
-    if (vertices.empty()) {
+    if (gpuVertices.empty()) {
         printf("[loadToGPU] ОШИБКА: Нет вершин для загрузки в GPU\n");
-                return false; 
-            }
+        return false;
+    }
     
-    if (polygons.empty()) {
+    if (gpuIndices.empty()) {
         printf("[loadToGPU] ОШИБКА: Нет полигонов для загрузки в GPU\n");
         return false;
     }
     
-    //printf("[loadToGPU] Создаем VAO...\n");
     // Создаем VAO
-    glGenVertexArrays(1, &vao);
-    if (vao == 0) {
+    GLuint newVao = 0, newVbo = 0, newEbo = 0;
+    glGenVertexArrays(1, &newVao);
+    if (newVao == 0) {
         printf("[loadToGPU] ОШИБКА: Не удалось создать VAO\n");
-                        return false; 
-                    }
-    //printf("[loadToGPU] VAO создан: %u\n", vao);
+        return false;
+    }
     
-    glBindVertexArray(vao);
+    glBindVertexArray(newVao);
     
-    //printf("[DFF] Создаем VBO для вершин...\n");
-    // Создаем VBO для вершин
-    glGenBuffers(1, &vbo);
-    if (vbo == 0) {
-        printf("[DFF] ОШИБКА: Не удалось создать VBO\n");
-        glDeleteVertexArrays(1, &vao);
-        vao = 0;
-                        return false; 
-                    }
-    //printf("[DFF] VBO создан: %u\n", vbo);
+    // Один VBO с чередующимися позициями и нормалями и один EBO - оба копируются как есть
+    glGenBuffers(1, &newVbo);
+    glGenBuffers(1, &newEbo);
+    if (newVbo == 0 || newEbo == 0) {
+        printf("[DFF] ОШИБКА: Не удалось создать VBO/EBO\n");
+        glBindVertexArray(0);
+        glDeleteBuffers(1, &newVbo);
+        glDeleteBuffers(1, &newEbo);
+        glDeleteVertexArrays(1, &newVao);
+        return false;
+    }
+    
+    glBindBuffer(GL_ARRAY_BUFFER, newVbo);
+    glBufferData(GL_ARRAY_BUFFER, gpuVertices.size() * sizeof(GpuVertex), gpuVertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, newEbo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, gpuIndices.size(), gpuIndices.data(), GL_STATIC_DRAW);
     
-    glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    size_t vertexDataSize = vertices.size() * sizeof(Vertex);
-    //printf("[DFF] Загружаем %zu байт данных вершин в VBO...\n", vertexDataSize);
-    glBufferData(GL_ARRAY_BUFFER, vertexDataSize, vertices.data(), GL_STATIC_DRAW);
+    // Позиция - три float, нормаль - два нормализованных short (распаковываются в шейдере)
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GpuVertex), (void*)offsetof(GpuVertex, x));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(GpuVertex), (void*)offsetof(GpuVertex, normal));
+    glEnableVertexAttribArray(1);
     
     // Проверяем ошибки OpenGL
     GLenum error = glGetError();
     if (error != GL_NO_ERROR) {
-        printf("[DFF] ОШИБКА OpenGL при загрузке вершин: 0x%04X\n", error);
-        glDeleteBuffers(1, &vbo);
-        glDeleteVertexArrays(1, &vao);
-        vbo = 0;
-        vao = 0;
+        printf("[DFF] ОШИБКА OpenGL при загрузке модели: 0x%04X\n", error);
+        glBindVertexArray(0);
+        glDeleteBuffers(1, &newEbo);
+        glDeleteBuffers(1, &newVbo);
+        glDeleteVertexArrays(1, &newVao);
         return false;
     }
     
-    //printf("[DFF] Настраиваем атрибуты вершин...\n");
-    // Настраиваем атрибуты вершин
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // Добавляем атрибут для нормалей (если они есть)
-    if (!normals.empty()) {
-        //printf("[DFF] Настраиваем атрибут для нормалей...\n");
-        
-        // Создаем VBO для нормалей
-        glGenBuffers(1, &normalVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
-        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(Normal), normals.data(), GL_STATIC_DRAW);
-        
-        // Настраиваем атрибут нормалей
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Normal), (void*)0);
-        glEnableVertexAttribArray(1);
-        //printf("[DFF] Атрибут нормалей включен (%zu нормалей)\n", normals.size());
-        } else {
-        //printf("[DFF] ВНИМАНИЕ: Нормали не найдены, создаем их автоматически...\n");
-        // Создаем простые нормали для каждой грани
-        std::vector<Normal> faceNormals;
-        faceNormals.reserve(polygons.size());
-        
-        for (const auto& poly : polygons) {
-            // Вычисляем нормаль грани
-            const Vertex& v1 = vertices[poly.vertex1];
-            const Vertex& v2 = vertices[poly.vertex2];
-            const Vertex& v3 = vertices[poly.vertex3];
-            
-            // Вычисляем векторы рёбер
-            float edge1x = v2.x - v1.x;
-            float edge1y = v2.y - v1.y;
-            float edge1z = v2.z - v1.z;
-            
-            float edge2x = v3.x - v1.x;
-            float edge2y = v3.y - v1.y;
-            float edge2z = v3.z - v1.z;
-            
-            // Векторное произведение для получения нормали
-            float nx = edge1y * edge2z - edge1z * edge2y;
-            float ny = edge1z * edge2x - edge1x * edge2z;
-            float nz = edge1x * edge2y - edge1y * edge2x;
-            
-            // Нормализуем
-            float length = sqrtf(nx * nx + ny * ny + nz * nz);
-            if (length > 0.0001f) {
-                nx /= length;
-                ny /= length;
-                nz /= length;
-            }
-            
-            faceNormals.push_back(Normal(nx, ny, nz));
-        }
-        
-        // Создаем массив нормалей для вершин
-        std::vector<Normal> vertexNormals(vertices.size(), Normal(0.0f, 0.0f, 0.0f));
-        
-        // Присваиваем нормали граней к вершинам
-        for (size_t i = 0; i < polygons.size(); i++) {
-            const auto& poly = polygons[i];
-            const auto& normal = faceNormals[i];
-            
-            vertexNormals[poly.vertex1].x += normal.x;
-            vertexNormals[poly.vertex1].y += normal.y;
-            vertexNormals[poly.vertex1].z += normal.z;
-            
-            vertexNormals[poly.vertex2].x += normal.x;
-            vertexNormals[poly.vertex2].y += normal.y;
-            vertexNormals[poly.vertex2].z += normal.z;
-            
-            vertexNormals[poly.vertex3].x += normal.x;
-            vertexNormals[poly.vertex3].y += normal.y;
-            vertexNormals[poly.vertex3].z += normal.z;
-        }
-        
-        // Нормализуем нормали вершин
-        for (auto& normal : vertexNormals) {
-            float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
-            if (length > 0.0001f) {
-                normal.x /= length;
-                normal.y /= length;
-                normal.z /= length;
-            }
-        }
-        
-        // Обновляем массив нормалей
-        normals = vertexNormals;
-        
-        // Создаем VBO для нормалей
-        glGenBuffers(1, &normalVBO);
-        glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
-        glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(Normal), normals.data(), GL_STATIC_DRAW);
-        
-        // Настраиваем атрибут нормалей
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Normal), (void*)0);
-        glEnableVertexAttribArray(1);
-        
-        //printf("[DFF] Созданы и настроены нормали для освещения (%zu нормалей)\n", normals.size());
-    }
-    
-    // Создаем EBO для индексов
-    if (!polygons.empty()) {
-        //printf("[DFF] Создаем EBO для индексов...\n");
-        glGenBuffers(1, &ebo);
-        if (ebo == 0) {
-            printf("[DFF] ОШИБКА: Не удалось создать EBO\n");
-            glDeleteBuffers(1, &vbo);
-            glDeleteVertexArrays(1, &vao);
-            vbo = 0;
-            vao = 0;
-            return false;
-        }
-        //printf("[DFF] EBO создан: %u\n", ebo);
-        
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-        
-        // Конвертируем полигоны в индексы
-        std::vector<uint32_t> indices;
-        indices.reserve(polygons.size() * 3);
-        for (const auto& poly : polygons) {
-            indices.push_back(poly.vertex1);
-            indices.push_back(poly.vertex2);
-            indices.push_back(poly.vertex3);
-        }
-        
-        size_t indexDataSize = indices.size() * sizeof(uint32_t);
-        //printf("[DFF] Загружаем %zu индексов (%zu байт) в EBO...\n", indices.size(), indexDataSize);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexDataSize, indices.data(), GL_STATIC_DRAW);
-        
-        // Проверяем ошибки OpenGL
-        error = glGetError();
-        if (error != GL_NO_ERROR) {
-            printf("[DFF] ОШИБКА OpenGL при загрузке индексов: 0x%04X\n", error);
-            glDeleteBuffers(1, &ebo);
-            glDeleteBuffers(1, &vbo);
-            glDeleteVertexArrays(1, &vao);
-            ebo = 0;
-            vbo = 0;
-            vao = 0;
-            return false;
-        }
-    }
-    
     // Отвязываем VAO
     glBindVertexArray(0);
     
-    //printf("[DFF] Модель успешно загружена в GPU! VAO=%u, VBO=%u, EBO=%u\n", vao, vbo, ebo);
+    outVao = newVao;
+    outVbo = newVbo;
+    outEbo = newEbo;
     return true;
 }
 
+bool dff::DffModel::loadToGPU() {
+    //printf("[DFF] Загружаем модель в GPU: %zu вершин, %zu полигонов\n", vertices.size(), polygons.size());
+    
+    // Модель, собранная не декодером (например, вручную), упаковывается здесь
+    if (gpuVertices.empty() || gpuIndices.empty()) {
+        buildGpuBuffers();
+    }
+    
+    //printf("[DFF] Модель успешно загружена в GPU! VAO=%u, VBO=%u, EBO=%u\n", vao, vbo, ebo);
+    return createGpuBuffers(vao, vbo, ebo);
+}
+
 void dff::DffModel::clear() {
     name.clear();
     vertices.clear();
@@ -1629,6 +3140,13 @@ void dff::DffModel::clear() {
     vertexColors.clear();
     polygons.clear();
     materials.clear();
+    geometryRanges.clear();
+    gpuVertices.clear();
+    gpuIndices.clear();
+    gpuIndexCount = 0;
+    gpuIndexSize = 0;
+    cacheMissesBefore = 0;
+    cacheMissesAfter = 0;
     
     if (vao) {
         glDeleteVertexArrays(1, &vao);
@@ -1642,10 +3160,6 @@ void dff::DffModel::clear() {
         glDeleteBuffers(1, &ebo);
     ebo = 0;
     }
-    if (normalVBO) {
-        glDeleteBuffers(1, &normalVBO);
-        normalVBO = 0;
-    }
 }
 
 // ============================================================================
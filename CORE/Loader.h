@@ -3,8 +3,15 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
+#include <span>
 #include <map>
 #include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+
+class ThreadPool;
 
 // Перечисление типов данных в gta.dat
 enum class DataType {
@@ -92,6 +99,33 @@ public:
               x(px), y(py), z(pz), rx(rotx), ry(roty), rz(rotz), rw(rotw), lod(lodId) {}
     };
     
+    // Заголовок бинарного IPL ("bnry", потоковые *_streamN.ipl внутри gta3.img)
+    struct BinaryIplHeader {
+        char magic[4];               // "bnry"
+        int32_t instanceCount;       // Количество объектов INST
+        int32_t unknown1Count;
+        int32_t unknown2Count;
+        int32_t unknown3Count;
+        int32_t carCount;            // Количество машин CARS
+        int32_t unknown4Count;
+        int32_t instanceOffset;      // Смещение массива INST от начала файла
+        int32_t instanceSize;        // Не используется (0)
+        int32_t unknown1Offset, unknown1Size;
+        int32_t unknown2Offset, unknown2Size;
+        int32_t unknown3Offset, unknown3Size;
+        int32_t carOffset, carSize;
+        int32_t unknown4Offset, unknown4Size;
+    };
+    
+    // Запись INST бинарного IPL (имени модели нет - только ID)
+    struct BinaryIplInstance {
+        float x, y, z;
+        float rx, ry, rz, rw;
+        int32_t modelId;
+        int32_t interior;
+        int32_t lod;                 // Индекс LOD в текстовом IPL-владельце (-1 - нет)
+    };
+    
     // Класс для хранения всех данных из IPL файла
     class IplData {
     private:
@@ -102,9 +136,19 @@ public:
         // Добавить объект
         void addObject(const IplObject& obj) { objects.push_back(obj); }
         
+        // Зарезервировать место под count новых объектов
+        void reserveObjects(size_t count) { objects.reserve(objects.size() + count); }
+        
         // Получить все объекты
         const std::vector<IplObject>& getAllObjects() const { return objects; }
         
+        // Забрать объекты без копирования (IplData остается пустым)
+        std::vector<IplObject> takeObjects() {
+            std::vector<IplObject> result = std::move(objects);
+            objects.clear();
+            return result;
+        }
+        
         // Получить количество объектов
         size_t getObjectCount() const { return objects.size(); }
         
@@ -121,18 +165,89 @@ public:
     // Функция для загрузки и парсинга IPL файла
     static bool loadIplFile(const char* filePath, IplData& iplData);
     
+    // Разобрать бинарный IPL из памяти (например, запись IMG архива); объекты дописываются в iplData
+    // с пустыми именами - имя определяется по ID модели
+    static bool loadBinaryIpl(std::span<const uint8_t> data, IplData& iplData);
+    
+    // Проверить сигнатуру бинарного IPL
+    static bool isBinaryIpl(std::span<const uint8_t> data);
+    
+    // Разобрать текст IPL файла (объекты секций INST добавляются в iplData)
+    static bool parseIplText(std::string_view text, IplData& iplData);
+    
+    // Разобрать строку INST (string_view + from_chars, без выделения памяти кроме имени)
+    static bool parseInstLine(std::string_view line, IplObject& object);
+    
+    // Прежний разбор строки INST через istringstream (для сравнения в бенчмарке)
+    static bool parseInstLineLegacy(const std::string& line, IplObject& object);
+    
     // Функция для поиска объектов по ID модели
     static std::vector<IplObject> findObjectsByModelId(const IplData& iplData, int modelId);
     
     // Функция для поиска объектов по имени
     static std::vector<IplObject> findObjectsByName(const IplData& iplData, const std::string& name);
+};
 
-private:
-    // Вспомогательная функция для парсинга секции INST
-    static bool parseInstSection(std::ifstream& file, IplData& iplData);
-    
-    // Вспомогательная функция для парсинга строки INST
-    static bool parseInstLine(const std::string& line, IplObject& object);
+// Класс для работы с IDE файлами (определения моделей: секции objs, tobj, anim)
+class ide {
+public:
+    // Секция, из которой взято определение
+    enum class Section {
+        Objs,   // Обычный объект
+        Tobj,   // Объект, видимый по времени суток
+        Anim    // Объект с анимацией
+    };
+
+    // Определение модели
+    struct ObjectDefinition {
+        int modelId;
+        std::string modelName;
+        std::string txdName;
+        std::string animName;   // Только anim
+        float drawDistance;     // Дальность прорисовки (для нескольких мешей - наибольшая)
+        uint32_t flags;
+        int timeOn, timeOff;    // Только tobj (-1 - всегда видим)
+        Section section;
+
+        ObjectDefinition()
+            : modelId(-1), drawDistance(0.0f), flags(0), timeOn(-1), timeOff(-1), section(Section::Objs) {}
+    };
+
+    // Таблица определений: ID модели -> определение (более поздний IDE перекрывает ранний)
+    class IdeData {
+    private:
+        std::map<int, ObjectDefinition> definitions;
+        std::map<std::string, int> idsByName;   // Имя модели в нижнем регистре -> ID
+
+    public:
+        // Добавить определение
+        void addDefinition(const ObjectDefinition& definition);
+
+        // Добавить все определения другой таблицы
+        void merge(const IdeData& other);
+
+        // Найти определение по ID / по имени модели без учета регистра (nullptr - нет)
+        const ObjectDefinition* findById(int modelId) const;
+        const ObjectDefinition* findByName(std::string_view modelName) const;
+
+        // Получить все определения
+        const std::map<int, ObjectDefinition>& getAllDefinitions() const { return definitions; }
+
+        // Получить количество определений
+        size_t getDefinitionCount() const { return definitions.size(); }
+
+        // Очистить все данные
+        void clear() { definitions.clear(); idsByName.clear(); }
+    };
+
+    // Функция для загрузки и парсинга IDE файла (определения дописываются в ideData)
+    static bool loadIdeFile(const char* filePath, IdeData& ideData);
+
+    // Разобрать текст IDE файла (секции objs, tobj, anim; остальные пропускаются)
+    static bool parseIdeText(std::string_view text, IdeData& ideData);
+
+    // Разобрать строку секции objs/tobj/anim
+    static bool parseObjectLine(std::string_view line, Section section, ObjectDefinition& definition);
 };
 
 // Класс для работы с IMG файлами (GTA SA - IMG v2)
@@ -146,6 +261,13 @@ public:
         V2_EXTENDED_SA  // GTA SA с расширенными лимитами (FLA)
     };
 
+    // Режим открытия IMG архива
+    enum class ImgLoadMode {
+        Eager,          // Сразу читаем данные всех файлов в память
+        Lazy,           // Читаем только каталог, данные файла - при первом обращении
+        Mapped          // Отображаем архив в память, файлы отдаются как представления без копирования
+    };
+
     // Структура заголовка IMG файла (GTA SA - IMG v2)
     struct ImgHeader {
         char magic[4];           // Магическое число "VER2"
@@ -198,6 +320,20 @@ public:
         }
     };
     
+    // Невладеющее представление файла из IMG (данные принадлежат архиву)
+    struct ImgFileView {
+        std::string_view name;               // Имя файла (живет, пока жив архив)
+        std::span<const uint8_t> data;       // Байты файла внутри архива
+    };
+    
+    // Результат пакетного чтения файлов из IMG (fetchBatch)
+    struct ImgBatch {
+        std::vector<std::vector<uint8_t>> buffers;   // Буферы крупных последовательных чтений (в режиме Mapped пусто)
+        std::vector<ImgFileView> views;              // Представления в порядке запрошенных имен (пустые data - файла нет)
+        size_t runCount = 0;                         // Количество слитых диапазонов секторов (= количество чтений)
+        uint64_t bytesRead = 0;                      // Прочитано байт с учетом пропусков между файлами
+    };
+    
     // Класс для управления IMG файлами
     class ImgData {
     private:
@@ -206,33 +342,73 @@ public:
         ImgHeaderExtended headerExtended;        // Расширенный заголовок
         std::vector<ImgFileEntry> fileEntries;   // Стандартные записи файлов
         std::vector<ImgFileEntryExtended> fileEntriesExtended; // Расширенные записи
-        std::map<std::string, ImgFile> files;    // Быстрый доступ к файлам по имени
+        std::map<std::string, size_t> entryIndex; // Имя файла -> индекс записи в каталоге
+        mutable std::map<std::string, ImgFile> files; // Загруженные данные файлов по имени
+        mutable std::ifstream dataStream;        // Открытый архив для ленивого чтения
+        mutable std::mutex dataMutex;            // Защита dataStream и files при ленивом чтении
+        const uint8_t* mappedData;               // Отображенный в память архив (режим Mapped)
+        uint64_t mappedSize;                     // Размер отображения в байтах
+        void* mapFileHandle;                     // Дескриптор файла отображения (Windows)
+        void* mapViewHandle;                     // Дескриптор объекта отображения (Windows)
         ImgVersion version;                      // Версия IMG файла
+        ImgLoadMode loadMode;                    // Режим открытия архива
         bool isExtended;                         // Флаг расширенного формата
         
     public:
         // Конструктор
         ImgData() : header{0, 0, 0, 0}, headerExtended{0, 0, 0, 0}, 
-                    version(ImgVersion::V2_GTA_SA), isExtended(false) {}
+                    mappedData(nullptr), mappedSize(0), mapFileHandle(nullptr), mapViewHandle(nullptr),
+                    version(ImgVersion::V2_GTA_SA), loadMode(ImgLoadMode::Eager), isExtended(false) {}
+        
+        // Деструктор (снимает отображение архива)
+        ~ImgData();
         
         // Загрузить IMG файл (автоопределение версии)
-        bool loadImgFile(const char* filePath);
+        bool loadImgFile(const char* filePath, ImgLoadMode mode = ImgLoadMode::Eager);
         
         // Принудительная загрузка определенной версии
-        bool loadImgFileVersion(const char* filePath, ImgVersion forcedVersion);
+        bool loadImgFileVersion(const char* filePath, ImgVersion forcedVersion, ImgLoadMode mode = ImgLoadMode::Eager);
         
         // Получить версию IMG файла
         ImgVersion getVersion() const { return version; }
         
+        // Получить режим открытия архива
+        ImgLoadMode getLoadMode() const { return loadMode; }
+        
         // Проверить, является ли файл расширенным
         bool isExtendedFormat() const { return isExtended; }
         
         // Получить список всех имен файлов
         std::vector<std::string> getAllFileNames() const;
         
-        // Получить файл по имени
+        // Получить файл по имени (в режиме Lazy данные читаются при первом обращении).
+        // Файл остается в кэше архива: в режиме Mapped это копия отображения, для чтения - getFileView
         const ImgFile* getFile(const std::string& fileName) const;
         
+        // Скопировать файл в собственный буфер вызывающего (в режиме Mapped - из отображения,
+        // кэш архива не растет)
+        bool copyFile(const std::string& fileName, ImgFile& file) const;
+        
+        // Получить байты файла без копирования (пустой span, если файла нет)
+        std::span<const uint8_t> getFileView(const std::string& fileName) const;
+        
+        // Получить байты файла по индексу записи каталога без копирования
+        std::span<const uint8_t> getFileViewByIndex(size_t index) const;
+        
+        // Пакетное чтение: записи сортируются по смещению, соседние диапазоны секторов (с разрывом
+        // не больше maxGapSectors) сливаются в одно последовательное чтение.
+        // Представления живут, пока живы batch и архив.
+        bool fetchBatch(const std::vector<std::string>& fileNames, ImgBatch& batch, uint32_t maxGapSectors = 16) const;
+        
+        // Количество записей каталога и имя записи по индексу (для построения индексов)
+        size_t getEntryCount() const { return isExtended ? fileEntriesExtended.size() : fileEntries.size(); }
+        const char* getEntryName(size_t index) const { 
+            return isExtended ? fileEntriesExtended[index].name : fileEntries[index].name; 
+        }
+        
+        // Смещение и размер записи каталога в байтах
+        void getEntryRange(size_t index, uint64_t& offsetBytes, uint64_t& sizeBytes) const;
+        
         // Проверить существование файла
         bool fileExists(const std::string& fileName) const;
         
@@ -247,6 +423,15 @@ public:
         // Получить все файлы определенного типа (например, только .dff)
         std::vector<ImgFile> getFilesByExtension(const std::string& ext) const;
         
+        // Получить представления всех файлов определенного типа без копирования данных
+        std::vector<ImgFileView> getFileViewsByExtension(const std::string& ext) const;
+        
+        // Посчитать файлы определенного типа без чтения их данных
+        size_t getFileCountByExtension(const std::string& ext) const;
+        
+        // Количество файлов, данные которых уже прочитаны в память
+        size_t getLoadedFileCount() const;
+        
         // Очистить все данные
         void clear();
         
@@ -258,8 +443,24 @@ public:
         // Вспомогательные методы
         bool parseHeader(std::ifstream& file);
         bool parseFileEntries(std::ifstream& file, const std::string& imgFileName = "");
-        bool loadFileData(std::ifstream& file, ImgFileEntry& entry, ImgFile& imgFile, const std::string& imgFileName = "");
-        bool loadFileDataExtended(std::ifstream& file, ImgFileEntryExtended& entry, ImgFile& imgFile, const std::string& imgFileName = "");
+        bool loadFileData(std::ifstream& file, ImgFileEntry& entry, ImgFile& imgFile, const std::string& imgFileName = "") const;
+        bool loadFileDataExtended(std::ifstream& file, ImgFileEntryExtended& entry, ImgFile& imgFile, const std::string& imgFileName = "") const;
+        
+        // Общая часть загрузки после определения версии
+        bool loadFromStream(std::ifstream& file, ImgLoadMode mode);
+        
+        // Построить индекс имен по прочитанному каталогу
+        void buildEntryIndex();
+        
+        // Прочитать данные записи каталога по ее индексу
+        bool readEntryData(std::ifstream& file, size_t index, ImgFile& imgFile) const;
+        
+        // Байты записи каталога внутри отображенного архива
+        std::span<const uint8_t> getMappedEntryView(size_t index) const;
+        
+        // Отображение архива в память и его снятие
+        bool mapArchive();
+        void unmapArchive();
         
         // Автоопределение версии IMG
         ImgVersion detectImgVersion(std::ifstream& file);
@@ -268,19 +469,114 @@ public:
         ImgFileEntry convertToStandardEntry(const ImgFileEntryExtended& extendedEntry) const;
     };
     
+    // Глобальный индекс файлов всех загруженных IMG архивов.
+    // Открытая адресация, ключ - имя записи (24 байта, нижний регистр, добито нулями).
+    // Приоритет как у findModelByName: файл из более раннего архива затеняет одноименные в последующих.
+    class AssetIndex {
+    public:
+        // Слот хэш-таблицы
+        struct Entry {
+            char key[24];        // Имя в нижнем регистре (пустой слот - key[0] == 0)
+            uint64_t hash;       // Хэш ключа (сравниваем до memcmp)
+            uint32_t archive;    // Индекс архива в списке (меньше - выше приоритет)
+            uint32_t entry;      // Индекс записи в каталоге архива
+            uint64_t contentHash;     // Хэш содержимого (0 - запись еще не запрашивалась)
+            uint32_t contentArchive;  // Первая запрошенная запись с таким же содержимым (до запроса - сама запись)
+            uint32_t contentEntry;
+        };
+        
+        // Запись, в которой лежит содержимое
+        struct ContentRef {
+            uint32_t archive;
+            uint32_t entry;
+        };
+        
+        AssetIndex() : count(0), shadowedCount(0), maxProbe(0), dedupCount(0), dedupBytes(0) {}
+        
+        // Построить индекс по списку архивов (порядок списка задает приоритет)
+        void build(const std::vector<ImgData*>& imgArchives);
+        
+        // Найти запись по имени файла (регистр не важен), nullptr если нет
+        const Entry* find(std::string_view fileName) const;
+        
+        // Проверить существование файла
+        bool contains(std::string_view fileName) const { return find(fileName) != nullptr; }
+        
+        // Первая копия содержимого записи. Дедупликация ленивая: хэш байтов записи (без добивки
+        // до сектора) считается при первом запросе, когда запись все равно читается; совпавшее
+        // содержимое сводится к первой запрошенной копии. Архивы в режиме Lazy не хэшируются
+        ContentRef getContent(const Entry& entry) const;
+        
+        // Получить байты файла без копирования (пустой span, если файла нет).
+        // Для дубликата возвращаются байты первой записи с тем же содержимым.
+        std::span<const uint8_t> getView(std::string_view fileName) const;
+        
+        // Архив, в котором лежит найденная запись
+        ImgData* getArchive(const Entry& entry) const { return archives[entry.archive]; }
+        
+        // Архив, в котором лежит содержимое записи (для дубликата - архив первой копии)
+        ImgData* getContentArchive(const Entry& entry) const { return archives[getContent(entry).archive]; }
+        
+        // Статистика индекса
+        size_t size() const { return count; }
+        size_t getCapacity() const { return slots.size(); }
+        size_t getShadowedCount() const { return shadowedCount; }
+        size_t getMaxProbe() const { return maxProbe; }
+        size_t getDedupCount() const { std::lock_guard<std::mutex> lock(contentMutex); return dedupCount; }
+        uint64_t getDedupBytes() const { std::lock_guard<std::mutex> lock(contentMutex); return dedupBytes; }
+        
+        void clear();
+        
+        // Быстрый некриптографический хэш содержимого файла
+        static uint64_t hashContent(std::span<const uint8_t> data);
+        
+    private:
+        // Привести имя к ключу: нижний регистр, 24 байта, добито нулями (false - имя не помещается)
+        static bool makeKey(std::string_view fileName, char key[24]);
+        static uint64_t hashKey(const char key[24]);
+        
+        // Байты содержимого записи без добивки до границы сектора
+        static std::span<const uint8_t> contentBytes(std::span<const uint8_t> data);
+        
+        std::vector<Entry> slots;            // Размер - степень двойки, заполнение не больше 50%
+        std::vector<ImgData*> archives;      // Архивы в порядке приоритета
+        size_t count;                        // Количество уникальных имен
+        size_t shadowedCount;                // Записи, затененные более приоритетными архивами
+        size_t maxProbe;                     // Самая длинная цепочка проб при вставке
+        
+        // Ленивая дедупликация: поля содержимого записей и первые копии меняются под мьютексом
+        mutable std::mutex contentMutex;
+        mutable std::map<uint64_t, std::vector<ContentRef>> firstCopies;   // Хэш содержимого -> первые копии
+        mutable size_t dedupCount;           // Запрошенные записи, совпавшие по содержимому с более ранними
+        mutable uint64_t dedupBytes;         // Байты, которые не нужно хранить и разбирать повторно
+    };
+    
     // Статические функции для работы с IMG
-    static bool loadImgFile(const char* filePath, ImgData& imgData);
+    static bool loadImgFile(const char* filePath, ImgData& imgData, ImgLoadMode mode = ImgLoadMode::Eager);
     static std::vector<ImgFile> findFilesByExtension(const ImgData& imgData, const std::string& extension);
     static std::vector<ImgFile> findFilesByNamePattern(const ImgData& imgData, const std::string& pattern);
     
     // Новые функции для поиска моделей по названию
     static const ImgFile* findModelByName(const std::vector<ImgData*>& imgArchives, const std::string& modelName);
     static std::vector<uint8_t> getModelData(const std::vector<ImgData*>& imgArchives, const std::string& modelName);
+    static std::span<const uint8_t> getModelView(const std::vector<ImgData*>& imgArchives, const std::string& modelName);
     static bool modelExists(const std::vector<ImgData*>& imgArchives, const std::string& modelName);
     
     // Функция для автопоиска .img файлов в папке models
     static std::vector<std::string> findImgFilesInModelsFolder();
     
+    // Статистика переупаковки IMG
+    struct RepackStats {
+        size_t placedEntries = 0;     // Записи, упорядоченные по положению в мире
+        size_t unplacedEntries = 0;   // Записи без размещений в IPL (txd, col...) - в конце, в исходном порядке
+        uint64_t outputSectors = 0;   // Размер результата в секторах
+    };
+    
+    // Переупаковать архив в стандартный VER2: файлы упорядочены по кривой Мортона
+    // (Z-order) от позиций их объектов в IPL, чтобы соседние в мире модели лежали рядом в файле
+    static bool repackImgSpatial(const ImgData& source, const std::vector<ipl::IplObject>& objects,
+                                 const char* outputPath, RepackStats* stats = nullptr);
+    
     // Утилиты для работы с большими файлами
     static bool isLargeFileSupported(const ImgData& imgData);
     static std::string getVersionString(ImgVersion version);
@@ -333,6 +629,13 @@ public:
             : vertex1(v1), vertex2(v2), vertex3(v3), materialId(matId) {}
     };
     
+    // Вершина в формате GPU: позиция и нормаль, упакованная октаэдрически в два snorm16 (16 байт
+    // вместо 24 у отдельных массивов позиций и нормалей)
+    struct GpuVertex {
+        float x, y, z;
+        int16_t normal[2];
+    };
+    
     // Структура для хранения материала
     struct Material {
         std::string name;
@@ -343,7 +646,23 @@ public:
         Material() : ambient(1.0f), diffuse(1.0f), specular(0.0f) {}
     };
     
-    // Структура для хранения загруженной DFF модели (только геометрия)
+    // Матрица фрейма RenderWare: строки right, up, at (поворот) и pos (позиция)
+    struct FrameMatrix {
+        float rows[4][3];
+    };
+    
+    // Часть объединенной модели, пришедшая из одного атомика клампа
+    struct GeometryRange {
+        uint32_t geometryIndex;             // Номер геометрии в GEOMETRY_LIST
+        uint32_t frameIndex;                // Фрейм атомика, чья матрица применена к вершинам (kNoFrame - нет)
+        uint32_t firstVertex, vertexCount;
+        uint32_t firstPolygon, polygonCount;
+        
+        static const uint32_t kNoFrame = 0xFFFFFFFFu;
+    };
+    
+    // Структура для хранения загруженной DFF модели (только геометрия).
+    // Все геометрии клампа объединены в один поток вершин/индексов в координатах клампа
     struct DffModel {
         std::string name;
         std::vector<Vertex> vertices;
@@ -352,59 +671,142 @@ public:
         std::vector<VertexColor> vertexColors;
         std::vector<Polygon> polygons;
         std::vector<Material> materials;
-        uint32_t vao, vbo, ebo, normalVBO;
+        std::vector<GeometryRange> geometryRanges;
+        
+        // Готовые буферы для GPU, собираются при декодировании: чередующиеся вершины и индексы
+        // треугольников (uint16_t, если вершин меньше 65536, иначе uint32_t)
+        std::vector<GpuVertex> gpuVertices;
+        std::vector<uint8_t> gpuIndices;
+        uint32_t gpuIndexCount;
+        uint32_t gpuIndexSize;              // Байт на индекс: 2 или 4
+        
+        // Промахи кэша вершин GPU (модель FIFO) для порядка треугольников из файла и после
+        // переупорядочивания при импорте; ACMR = промахи / треугольники
+        uint32_t cacheMissesBefore;
+        uint32_t cacheMissesAfter;
+        
+        uint32_t vao, vbo, ebo;
         
         // Конструктор по умолчанию
-        DffModel() : vao(0), vbo(0), ebo(0), normalVBO(0) {}
+        DffModel() : gpuIndexCount(0), gpuIndexSize(0), cacheMissesBefore(0), cacheMissesAfter(0), vao(0), vbo(0), ebo(0) {}
         
-        // Методы для получения количества элементов
-        size_t getVertexCount() const { return vertices.size(); }
-        size_t getPolygonCount() const { return polygons.size(); }
-        size_t getNormalCount() const { return normals.size(); }
+        // Методы для получения количества элементов. После buildGpuBuffers распакованные массивы
+        // освобождены - количества берутся из упакованных буферов (нормаль есть у каждой вершины)
+        size_t getVertexCount() const { return gpuVertices.empty() ? vertices.size() : gpuVertices.size(); }
+        size_t getPolygonCount() const { return gpuIndexCount != 0 ? gpuIndexCount / 3 : polygons.size(); }
+        size_t getNormalCount() const { return gpuVertices.empty() ? normals.size() : gpuVertices.size(); }
         size_t getMaterialCount() const { return materials.size(); }
+        float getAcmrBefore() const { return getPolygonCount() == 0 ? 0.0f : static_cast<float>(cacheMissesBefore) / getPolygonCount(); }
+        float getAcmrAfter() const { return getPolygonCount() == 0 ? 0.0f : static_cast<float>(cacheMissesAfter) / getPolygonCount(); }
+        
+        // Индекс вершины из упакованного буфера индексов
+        uint32_t getGpuIndex(size_t i) const;
         
         // Методы для работы с GPU
+        void buildGpuBuffers();             // Упаковать вершины/нормали/полигоны; распакованные массивы освобождаются
+        uint32_t getGpuIndexType() const;   // GL_UNSIGNED_SHORT или GL_UNSIGNED_INT
+        // Создать VAO/VBO/EBO из готовых буферов; модель не меняется, поэтому одну разделяемую
+        // модель можно загрузить в GPU один раз для всех ее размещений
+        bool createGpuBuffers(uint32_t& outVao, uint32_t& outVbo, uint32_t& outEbo) const;
         bool loadToGPU();
         void clear();
     };
     
+    // Секция RenderWare: заголовок и представление содержимого внутри исходного буфера
+    struct Chunk {
+        uint32_t id;
+        uint32_t size;
+        uint32_t version;
+        std::span<const uint8_t> data;      // Содержимое без заголовка
+        
+        Chunk() : id(0), size(0), version(0) {}
+    };
+    
+    // Обход секций одного уровня без копирования. Заголовки читаются по мере продвижения;
+    // секция, выходящая за границы родителя, останавливает обход с ошибкой - битый файл
+    // отбрасывается за число прочитанных заголовков, без чтения за концом буфера
+    class ChunkWalker {
+    public:
+        explicit ChunkWalker(std::span<const uint8_t> data) : m_data(data), m_offset(0), m_failed(false) {}
+        
+        // Следующая секция (false - секции кончились или заголовок битый, см. failed)
+        bool next(Chunk& chunk);
+        
+        // Следующая секция с данным ID; остальные пропускаются по размеру из заголовка
+        bool find(uint32_t id, Chunk& chunk);
+        
+        bool failed() const { return m_failed; }
+        
+    private:
+        std::span<const uint8_t> m_data;
+        size_t m_offset;
+        bool m_failed;
+    };
+    
+    // Последовательное чтение полей из содержимого секции с проверкой границ.
+    // После первой ошибки все чтения неуспешны
+    class ChunkReader {
+    public:
+        explicit ChunkReader(std::span<const uint8_t> data) : m_data(data), m_offset(0), m_failed(false) {}
+        
+        template<typename T>
+        bool read(T& value) {
+            const uint8_t* bytes = take(sizeof(T));
+            if (!bytes) {
+                return false;
+            }
+            memcpy(&value, bytes, sizeof(T));
+            return true;
+        }
+        
+        // Следующие count байт (nullptr - столько нет)
+        const uint8_t* take(size_t count);
+        
+        // Пропустить count элементов размера elementSize (с проверкой переполнения)
+        bool skip(size_t count, size_t elementSize = 1);
+        
+        size_t remaining() const { return m_data.size() - m_offset; }
+        bool failed() const { return m_failed; }
+        
+    private:
+        std::span<const uint8_t> m_data;
+        size_t m_offset;
+        bool m_failed;
+    };
+    
     // Класс для управления DFF файлами
     class DffData {
     private:
         std::string fileName;
         DffModel model;
-        
-        // Внутренние переменные для парсинга (как в DffImporter)
-        char* buffer;
-        unsigned int bufIndex;
-        std::streamsize fileSize;
-        bool noIssues;
-        
-        // Методы парсинга из DffImporter
-        bool parseFile();
-        bool parseClump();
-        bool findAndParseGeometryList();
-        bool parseFrameList();
-        bool parseGeometryList();
-        bool parseGeometry(const uint32_t& gIndex);
-        bool parseMaterialList(const uint32_t& geoIndex);
-        bool parseMaterial(const uint32_t& matID);
-        bool parseTexture();
-        bool parseBinMesh();
-        bool parseExtension();
-        
-        // Вспомогательные методы
-        template<typename T>
-        T readBuffer(const unsigned int& inc);
-        template<typename T>
-        T readNumeric();
+        std::vector<uint8_t> ownedBuffer;    // Данные, прочитанные из файла самим DffData
+        
+        // Атомик: какую геометрию рисовать и каким фреймом
+        struct Atomic {
+            uint32_t frameIndex;
+            uint32_t geometryIndex;
+        };
+        
+        // Разбор секций (каждая получает свое содержимое; чужие секции не читаются)
+        bool parseFile(std::span<const uint8_t> data);
+        bool parseClump(const Chunk& clump);
+        bool parseFrameList(const Chunk& frameList, std::vector<FrameMatrix>& worldMatrices);
+        bool parseGeometryList(const Chunk& geometryList, std::vector<DffModel>& geometries);
+        bool parseGeometry(const Chunk& geometry, uint32_t gIndex, DffModel& geometryModel);
+        bool parseMaterialList(const Chunk& materialList, uint32_t geoIndex, DffModel& geometryModel);
+        bool parseBinMesh(const Chunk& binMesh, uint32_t vertexCount, std::vector<Polygon>& polygons);
+        bool parseAtomic(const Chunk& atomic, Atomic& result);
+        
+        // Слить геометрии атомиков в model, применив матрицы их фреймов
+        void mergeGeometries(std::vector<DffModel>& geometries, const std::vector<FrameMatrix>& worldMatrices,
+                             const std::vector<Atomic>& atomics);
         
     public:
         DffData();
         ~DffData();
         
         bool loadDffFile(const char* filePath);
-        bool loadDffFromBuffer(const std::vector<uint8_t>& data, const std::string& name = "");
+        bool loadDffFromBuffer(std::span<const uint8_t> data, const std::string& name = "");
         const DffModel& getModel() const { return model; }
         bool uploadToGPU();
         void clear();
@@ -412,8 +814,8 @@ public:
     
     // Статические функции для работы с DFF
     static bool loadDffFile(const char* filePath, DffData& dffData);
-    static bool loadDffFromBuffer(const std::vector<uint8_t>& data, DffData& dffData, const std::string& name = "");
-    static DffModel* createDffModel(const std::vector<uint8_t>& data, const std::string& name = "");
+    static bool loadDffFromBuffer(std::span<const uint8_t> data, DffData& dffData, const std::string& name = "");
+    static DffModel* createDffModel(std::span<const uint8_t> data, const std::string& name = "");
     static bool createTestDffFile(const char* filePath);
 };
 
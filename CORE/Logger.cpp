@@ -2,6 +2,7 @@
 #include <iostream>
 #include <cstdio>
 #include <cstdarg>
+#include <mutex>
 
 // Тип функции для добавления лога
 typedef void (*AddLogFunc)(void*, const std::string&, const std::string&, ImVec4);
@@ -18,6 +19,10 @@ void SetMenuInstance(void* menu, AddLogFunc addLogFunc) {
 
 // Основная функция логирования
 void LogToImGui(const std::string& message, const std::string& category, ImVec4 color) {
+    // Загрузчики пишут в лог из рабочих потоков
+    static std::mutex logMutex;
+    std::lock_guard<std::mutex> lock(logMutex);
+    
     if (g_menuInstance && g_addLogFunc) {
         // Вызываем функцию через указатель на функцию
         g_addLogFunc(g_menuInstance, message, category, color);
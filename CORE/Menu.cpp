@@ -385,6 +385,10 @@ void Menu::RenderPerformanceMonitor() {
         m_renderer->SetRenderRadius(renderRadius);
         OnRenderRadiusChanged(renderRadius);
     }
+        bool useDrawDistances = m_renderer->IsUsingModelDrawDistances();
+        if (ImGui::Checkbox("Дальность из IDE", &useDrawDistances)) {
+            m_renderer->SetUseModelDrawDistances(useDrawDistances);
+        }
         ImGui::EndChild();
     
         ImGui::SameLine();
@@ -404,7 +408,7 @@ void Menu::RenderPerformanceMonitor() {
         // Секция 5: Информация о моделях
         ImGui::BeginChild("ModelInfo", ImVec2(sectionWidth - 10, statsBarHeight - 15), true);
         ImGui::TextColored(ImVec4(0.5f, 1.0f, 0.5f, 1.0f), "МОДЕЛИ");
-        ImGui::Text("DFF моделей: %d", m_renderer->GetDffModelCount());
+        ImGui::Text("DFF моделей: %d (уникальных %d)", m_renderer->GetDffModelCount(), m_renderer->GetUniqueDffModelCount());
         ImGui::Text("GTA объектов: %d", m_renderer->GetGtaObjectCount());
         ImGui::EndChild();
         
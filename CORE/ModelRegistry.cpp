@@ -0,0 +1,96 @@
+#include "ModelRegistry.h"
+
+#include <GL/glew.h>
+
+uint32_t ModelRegistry::Acquire(uint64_t assetKey, const std::shared_ptr<const dff::DffModel>& model) {
+    if (!model) {
+        return kInvalidHandle;
+    }
+
+    auto it = m_handles.find(assetKey);
+    if (it != m_handles.end()) {
+        m_entries[it->second].refCount++;
+        return it->second;
+    }
+
+    uint32_t handle;
+    if (!m_freeHandles.empty()) {
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
+    }
+    else {
+        handle = static_cast<uint32_t>(m_entries.size());
+        m_entries.emplace_back();
+    }
+
+    Entry& entry = m_entries[handle];
+    entry = Entry();
+    entry.model = model;
+    entry.assetKey = assetKey;
+    entry.indexCount = model->gpuIndexCount;
+    entry.indexType = model->getGpuIndexType();
+    entry.refCount = 1;
+    m_handles.emplace(assetKey, handle);
+    return handle;
+}
+
+void ModelRegistry::Release(uint32_t handle) {
+    if (handle >= m_entries.size() || !m_entries[handle].model) {
+        return;
+    }
+
+    Entry& entry = m_entries[handle];
+    if (--entry.refCount > 0) {
+        return;
+    }
+
+    DeleteFromGPU(handle);
+    m_handles.erase(entry.assetKey);
+    entry.model.reset();
+    m_freeHandles.push_back(handle);
+}
+
+bool ModelRegistry::Upload(uint32_t handle) {
+    if (handle >= m_entries.size() || !m_entries[handle].model) {
+        return false;
+    }
+
+    Entry& entry = m_entries[handle];
+    if (entry.uploadedToGPU) {
+        return true;
+    }
+    if (!entry.model->createGpuBuffers(entry.vao, entry.vbo, entry.ebo)) {
+        return false;
+    }
+
+    entry.uploadedToGPU = true;
+    m_uploadedCount++;
+    return true;
+}
+
+void ModelRegistry::DeleteFromGPU(uint32_t handle) {
+    Entry& entry = m_entries[handle];
+    if (!entry.uploadedToGPU) {
+        return;
+    }
+
+    glDeleteVertexArrays(1, &entry.vao);
+    glDeleteBuffers(1, &entry.vbo);
+    glDeleteBuffers(1, &entry.ebo);
+    entry.vao = entry.vbo = entry.ebo = 0;
+    entry.uploadedToGPU = false;
+    m_uploadedCount--;
+}
+
+void ModelRegistry::DeleteAllFromGPU() {
+    for (uint32_t handle = 0; handle < m_entries.size(); handle++) {
+        DeleteFromGPU(handle);
+    }
+}
+
+void ModelRegistry::Clear() {
+    DeleteAllFromGPU();
+    m_entries.clear();
+    m_handles.clear();
+    m_freeHandles.clear();
+}
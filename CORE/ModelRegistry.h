@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+#include "Loader.h"
+
+// Реестр уникальных DFF моделей сцены с подсчетом ссылок.
+// Размещение хранит только дескриптор модели (и свою строку в таблице размещений), а геометрия
+// (общая с кэшем ассетов) и ее VAO/VBO/EBO существуют в одном экземпляре на модель: 200 фонарных
+// столбов - одна запись, одна загрузка в GPU. Память CPU и GPU растет с числом моделей, а не размещений.
+// Модель опознается по ключу кэша ассетов (запись IMG или файл), а не по адресу геометрии: модель,
+// вытесненная из кэша и разобранная заново, попадает в ту же запись реестра.
+class ModelRegistry {
+public:
+    static const uint32_t kInvalidHandle = 0xFFFFFFFFu;
+
+    // Запись реестра
+    struct Entry {
+        std::shared_ptr<const dff::DffModel> model;     // nullptr - слот свободен
+        uint64_t assetKey = 0;                          // Ключ модели в кэше ассетов
+        uint32_t vao = 0, vbo = 0, ebo = 0;
+        uint32_t indexCount = 0;
+        uint32_t indexType = 0;                         // GL_UNSIGNED_SHORT или GL_UNSIGNED_INT
+        bool uploadedToGPU = false;
+        uint32_t refCount = 0;                          // Сколько размещений ссылается на модель
+    };
+
+    // Взять ссылку на модель: тот же ключ кэша ассетов дает тот же дескриптор (геометрия
+    // и GPU буферы остаются от первого Acquire)
+    uint32_t Acquire(uint64_t assetKey, const std::shared_ptr<const dff::DffModel>& model);
+
+    // Отпустить ссылку; с последней удаляются GPU буферы и ссылка на геометрию, слот переиспользуется
+    void Release(uint32_t handle);
+
+    // Загрузить модель в GPU (один раз на модель; нужен текущий контекст OpenGL)
+    bool Upload(uint32_t handle);
+
+    // Удалить GPU буферы модели / всех моделей (геометрия остается, модель можно загрузить снова)
+    void DeleteFromGPU(uint32_t handle);
+    void DeleteAllFromGPU();
+
+    // Освободить все записи (GPU буферы удаляются). Деструктор буферы не трогает - их удаляет
+    // владелец контекста OpenGL до его закрытия
+    void Clear();
+
+    const Entry& Get(uint32_t handle) const { return m_entries[handle]; }
+    const dff::DffModel& GetModel(uint32_t handle) const { return *m_entries[handle].model; }
+
+    // Статистика
+    size_t GetModelCount() const { return m_handles.size(); }
+    size_t GetUploadedCount() const { return m_uploadedCount; }
+
+    // Обход живых записей
+    template <typename F>
+    void ForEach(F&& visit) const {
+        for (uint32_t handle = 0; handle < m_entries.size(); handle++) {
+            if (m_entries[handle].model) {
+                visit(handle, m_entries[handle]);
+            }
+        }
+    }
+
+private:
+    std::vector<Entry> m_entries;
+    std::unordered_map<uint64_t, uint32_t> m_handles;   // Ключ кэша ассетов -> дескриптор
+    std::vector<uint32_t> m_freeHandles;
+    size_t m_uploadedCount = 0;
+};
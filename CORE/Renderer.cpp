@@ -1,5 +1,6 @@
 #include "Renderer.h"
 #include "Logger.h"
+#include "AssetCache.h"
 #include <cmath>
 #include <iostream>
 #include <sstream>
@@ -22,6 +23,11 @@
 #include "../vendor/glm-master/glm/gtc/matrix_transform.hpp"
 #include "../vendor/glm-master/glm/gtc/type_ptr.hpp"
 
+// Переключение HD/LOD: дальность по умолчанию (у модели нет дальности из IDE) и полоса гистерезиса
+static const float kDefaultLodSwitchDistance = 300.0f;
+static const float kLodHysteresisFraction = 0.1f;
+static const float kLodHysteresisMin = 10.0f;
+
 // Больше не используется (fixed-function). Матрицы считаем через glm
 static glm::mat4 BuildPerspective(float fovyDeg, float aspect, float zNear, float zFar) {
     return glm::perspective(glm::radians(fovyDeg), aspect, zNear, zFar);
@@ -60,6 +66,8 @@ Renderer::Renderer() : m_window(nullptr), m_width(0), m_height(0), m_initialized
     m_totalVertices(0), m_totalPolygons(0), m_dffVertices(0), m_dffPolygons(0), m_skyboxVertices(0), m_skyboxPolygons(0),
         m_useQuaternions(true), // По умолчанию включаем кватернионы
     m_renderRadius(1500.0f), // По умолчанию радиус 1500 единиц
+    m_modelDefinitions(nullptr), m_useModelDrawDistances(true), // Дальность из IDE, когда определения загружены
+    m_lodFrame(0), m_lodHiddenCount(0), // Иерархия LOD
     m_debugMode(false), // Отладочный режим выключен по умолчанию
     m_lastFrameTime(0.0), m_uploadTime(0.0), m_renderTime(0.0), // Профилирование
     m_visibleDffModels(), m_visibleGtaObjects(), // Инициализируем пустые векторы
@@ -250,14 +258,22 @@ bool Renderer::CreateGridResources() {
     static const char* modelVsSrc =
         "#version 330 core\n"
         "layout(location=0) in vec3 aPos;\n"
-        "layout(location=1) in vec3 aNormal;\n"
+        "layout(location=1) in vec2 aNormal;\n"
         "uniform mat4 uMVP;\n"
         "uniform mat4 uModel;\n"
         "out vec3 FragPos;\n"
         "out vec3 Normal;\n"
+        "// Распаковка октаэдрической нормали (см. dff::DffModel::buildGpuBuffers)\n"
+        "vec3 decodeOctahedral(vec2 e) {\n"
+        "    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+        "    float t = max(-n.z, 0.0);\n"
+        "    n.x += n.x >= 0.0 ? -t : t;\n"
+        "    n.y += n.y >= 0.0 ? -t : t;\n"
+        "    return normalize(n);\n"
+        "}\n"
         "void main() {\n"
         "    FragPos = vec3(uModel * vec4(aPos, 1.0));\n"
-        "    Normal = mat3(transpose(inverse(uModel))) * aNormal;\n"
+        "    Normal = mat3(transpose(inverse(uModel))) * decodeOctahedral(aNormal);\n"
         "    gl_Position = uMVP * vec4(aPos, 1.0);\n"
         "}\n";
     static const char* modelFsSrc =
@@ -385,6 +401,9 @@ void Renderer::SetupCallbacks() {
 }
 
 void Renderer::Shutdown() {
+    // GPU буферы моделей удаляются, пока контекст OpenGL еще жив
+    ClearDffModels();
+    
     // Очищаем Menu систему
     m_menu.Shutdown();
     DestroyGridResources();
@@ -723,24 +742,26 @@ bool Renderer::IsImGuiHovered() const {
 
 // Метод для установки GTA объектов
 void Renderer::SetGtaObjects(const std::vector<ipl::IplObject>& objects) {
-    m_gtaObjects = objects;
+    m_gtaObjects.Clear();
+    m_gtaObjects.AddIplObjects(objects);
+    ApplyModelDrawDistances(m_gtaObjects);
     //printf("[Renderer] Установлено %zu GTA объектов для отрисовки\n", m_gtaObjects.size());
 }
 
 // Метод для добавления одного GTA объекта
 void Renderer::AddGtaObject(const ipl::IplObject& object) {
-    m_gtaObjects.push_back(object);
+    size_t row = m_gtaObjects.AddIplObject(object);
+    ApplyModelDrawDistance(m_gtaObjects, m_gtaObjects.GetModelHandles()[row]);
     //printf("[Renderer] Добавлен объект: ID: %d, Имя: %s, Позиция: (%.2f, %.2f, %.2f), Поворот: (%.2f, %.2f, %.2f, %.2f)\n", 
            //object.modelId, object.name.c_str(), object.x, object.y, object.z, object.rx, object.ry, object.rz, object.rw);
 }
 
 // Метод для добавления тестового объекта с отдельными параметрами
 void Renderer::AddTestObject(int index, int modelId, const char* name, float x, float y, float z, float rx, float ry, float rz, float rw) {
-    // Создаем объект с переданными параметрами
-    ipl::IplObject testObject(modelId, name, 0, x, y, z, rx, ry, rz, rw, 0);
-    
-    // Добавляем в вектор объектов
-    m_gtaObjects.push_back(testObject);
+    // Добавляем объект в таблицу (имя модели хранится один раз на все кубы с этим именем)
+    uint32_t modelHandle = m_gtaObjects.InternModel(name ? name : "", modelId);
+    m_gtaObjects.AddInstance(modelHandle, x, y, z, { rx, ry, rz, rw }, 0, 0);
+    ApplyModelDrawDistance(m_gtaObjects, modelHandle);
     
     // Выводим информацию о кватернионе
     float quatLength = sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
@@ -757,8 +778,8 @@ void Renderer::AddTestObject(int index, int modelId, const char* name, float x,
 
 // Метод для отрисовки GTA объектов в виде кубов
 void Renderer::RenderGtaObjects() {
-    // Получаем только видимые GTA объекты
-    const std::vector<ipl::IplObject>& visibleObjects = GetVisibleGtaObjects();
+    // Получаем только видимые GTA объекты (индексы строк таблицы)
+    const std::vector<uint32_t>& visibleObjects = GetVisibleGtaObjects();
 
     if (visibleObjects.empty()) {
         return; // Нет видимых объектов
@@ -844,29 +865,37 @@ void Renderer::RenderGtaObjects() {
         glm::vec4(0.5f, 0.0f, 1.0f, 1.0f)  // Фиолетовый
     };
 
+    // Колонки таблицы объектов
+    const std::vector<float>& objectX = m_gtaObjects.GetX();
+    const std::vector<float>& objectY = m_gtaObjects.GetY();
+    const std::vector<float>& objectZ = m_gtaObjects.GetZ();
+    const std::vector<SceneInstanceTable::Quaternion>& objectRotations = m_gtaObjects.GetRotations();
+
     // Рендерим каждый видимый объект как куб
     for (size_t i = 0; i < visibleObjects.size(); i++) {
-        const auto& obj = visibleObjects[i];
+        const uint32_t row = visibleObjects[i];
+        const SceneInstanceTable::Quaternion& rotation = objectRotations[row];
         
         // Выбираем цвет на основе ID модели
-        int colorIndex = obj.modelId % 8;
+        int colorIndex = m_gtaObjects.GetModelId(row) % 8;
+        if (colorIndex < 0) colorIndex += 8;
         if (locCol >= 0) glUniform4fv(locCol, 1, glm::value_ptr(colors[colorIndex]));
         
         // Модельная матрица из позиции и кватерниона
         glm::mat4 model(1.0f);
-        model = glm::translate(model, glm::vec3(obj.x, obj.y, obj.z));
+        model = glm::translate(model, glm::vec3(objectX[row], objectY[row], objectZ[row]));
         model = glm::scale(model, glm::vec3(cubeSize));
         
         // Применяем поворот только если кватернион не единичный
-        if (m_useQuaternions && (abs(obj.rx) > 0.001f || abs(obj.ry) > 0.001f || abs(obj.rz) > 0.001f || abs(obj.rw - 1.0f) > 0.001f)) {
+        if (m_useQuaternions && (abs(rotation.x) > 0.001f || abs(rotation.y) > 0.001f || abs(rotation.z) > 0.001f || abs(rotation.w - 1.0f) > 0.001f)) {
             // Отладочная информация для первых нескольких объектов
             if (i < 3) {
                 //printf("[Cube %zu] Raw: rx=%.3f, ry=%.3f, rz=%.3f, rw=%.3f\n", 
-                       //i, obj.rx, obj.ry, obj.rz, obj.rw);
+                       //i, rotation.x, rotation.y, rotation.z, rotation.w);
             }
             
             // Используем ту же математику, что и в applyQuaternion
-            float rx = obj.rx, ry = obj.ry, rz = obj.rz, rw = obj.rw;
+            float rx = rotation.x, ry = rotation.y, rz = rotation.z, rw = rotation.w;
             float length = sqrtf(rx * rx + ry * ry + rz * rz + rw * rw);
             if (length > 0.0001f) {
                 rx /= length; ry /= length; rz /= length; rw /= length;
@@ -885,11 +914,11 @@ void Renderer::RenderGtaObjects() {
             {
                 //printf("[Cube %zu] Using custom quaternion matrix\n", i);
             }
-        } else if (!m_useQuaternions && (abs(obj.rx) > 0.001f || abs(obj.ry) > 0.001f || abs(obj.rz) > 0.001f)) {
+        } else if (!m_useQuaternions && (abs(rotation.x) > 0.001f || abs(rotation.y) > 0.001f || abs(rotation.z) > 0.001f)) {
             // Углы Эйлера (по умолчанию) - используем как есть
-            glm::mat4 rotEuler = glm::rotate(glm::mat4(1.0f), obj.rx, glm::vec3(1,0,0)) *  // X
-                                 glm::rotate(glm::mat4(1.0f), obj.ry, glm::vec3(0,1,0)) *  // Y
-                                 glm::rotate(glm::mat4(1.0f), obj.rz, glm::vec3(0,0,1)); // Z
+            glm::mat4 rotEuler = glm::rotate(glm::mat4(1.0f), rotation.x, glm::vec3(1,0,0)) *  // X
+                                 glm::rotate(glm::mat4(1.0f), rotation.y, glm::vec3(0,1,0)) *  // Y
+                                 glm::rotate(glm::mat4(1.0f), rotation.z, glm::vec3(0,0,1)); // Z
             
             model *= rotEuler;
         }
@@ -938,18 +967,16 @@ void Renderer::UpdateRenderStats() {
     m_skyboxPolygons = 0;
     
     // Подсчитываем статистику для DFF моделей отдельно
-    for (const auto& instance : m_dffModels) {
-        const auto& model = instance.model;
-        m_dffVertices += static_cast<int>(model.vertices.size());
-        m_dffPolygons += static_cast<int>(model.polygons.size());
+    for (uint32_t modelHandle : m_dffRowModels) {
+        const auto& model = m_dffModelRegistry.GetModel(modelHandle);
+        m_dffVertices += static_cast<int>(model.getVertexCount());
+        m_dffPolygons += static_cast<int>(model.getPolygonCount());
     }
     
     // Подсчитываем статистику для GTA объектов
-    for (const auto& obj : m_gtaObjects) {
-        // Куб: 6 граней (полигонов) и 24 вершины (4 вершины на грань)
-        m_totalPolygons += 6;
-        m_totalVertices += 24;
-    }
+    // Куб: 6 граней (полигонов) и 24 вершины (4 вершины на грань)
+    m_totalPolygons += static_cast<int>(m_gtaObjects.Size()) * 6;
+    m_totalVertices += static_cast<int>(m_gtaObjects.Size()) * 24;
     
     // Статистика скайбокса (отдельно)
     if (m_skyboxInitialized) {
@@ -964,72 +991,64 @@ void Renderer::UpdateRenderStats() {
     
     // Отладочная информация (закомментировано для производительности)
     //printf("[Renderer] UpdateRenderStats: DFF моделей: %zu, GTA объектов: %zu, вершин: %d, полигонов: %d\n", 
-           //m_dffModels.size(), m_gtaObjects.size(), m_totalVertices, m_totalPolygons);
+           //m_dffRowModels.size(), m_gtaObjects.size(), m_totalVertices, m_totalPolygons);
 }
 
 // ============================================================================
 // DFF MODEL RENDERING IMPLEMENTATION
 // ============================================================================
 
-void Renderer::AddDffModel(const dff::DffModel& model, const char* name, float x, float y, float z, float rx, float ry, float rz, float rw) {
-    //printf("[Renderer] AddDffModel: получена модель '%s' с %zu вершинами, %zu полигонами, %zu нормалями\n", 
-    //       name, model.vertices.size(), model.polygons.size(), model.normals.size());
+void Renderer::AddDffModel(uint64_t assetKey, const std::shared_ptr<const dff::DffModel>& model, const char* name, float x, float y, float z,
+                           float rx, float ry, float rz, float rw, int lodKey, int lodParentKey) {
+    if (!model) {
+        return;
+    }
+    //printf("[Renderer] AddDffModel: получена модель '%s' с %zu вершинами, %zu полигонами\n", 
+    //       name, model->getVertexCount(), model->getPolygonCount());
     
-    // Создаем экземпляр модели
-    DffModelInstance instance;
+    std::shared_ptr<const dff::DffModel> sceneModel = model;
+    uint64_t sceneModelKey = assetKey;
     
     // Проверяем валидность модели и выводим предупреждения только для проблемных
-    if (model.vertices.empty() || model.polygons.empty()) {
+    if (model->getVertexCount() == 0 || model->getPolygonCount() == 0) {
         printf("[Renderer] ⚠️  ПРОБЛЕМНАЯ МОДЕЛЬ '%s':\n", name);
-        printf("[Renderer]   - Вершины: %zu, Полигоны: %zu, Нормали: %zu\n", 
-               model.vertices.size(), model.polygons.size(), model.normals.size());
+        printf("[Renderer]   - Вершины: %zu, Полигоны: %zu\n", model->getVertexCount(), model->getPolygonCount());
         printf("[Renderer]   - Позиция: (%.1f, %.1f, %.1f)\n", x, y, z);
         
         // Если есть вершины, но нет полигонов - пробуем исправить из unpack
-        if (!model.vertices.empty() && model.polygons.empty()) {
+        if (model->getVertexCount() != 0 && model->getPolygonCount() == 0) {
             printf("[Renderer] 🔧 Попытка исправления модели '%s' из распакованных файлов...\n", name);
             
-            dff::DffModel fixedModel = LoadDffFromUnpack(name);
+            uint64_t fixedModelKey = 0;
+            std::shared_ptr<const dff::DffModel> fixedModel = LoadFallbackDff(name, fixedModelKey);
             
-            if (!fixedModel.polygons.empty()) {
+            if (fixedModel) {
                 printf("[Renderer] ✅ Модель '%s' успешно исправлена: %zu полигонов\n", 
-                       name, fixedModel.polygons.size());
+                       name, fixedModel->getPolygonCount());
                 // Используем исправленную модель
-                instance.model = fixedModel;
+                sceneModel = fixedModel;
+                sceneModelKey = fixedModelKey;
             } else {
-                printf("[Renderer] ❌ Не удалось исправить модель '%s' из unpack\n", name);
-                // Используем оригинальную модель
-                instance.model = model;
+                printf("[Renderer] ❌ Не удалось исправить модель '%s' из unpack или IMG\n", name);
             }
-        } else {
-            // Для полностью пустых моделей используем оригинал
-            instance.model = model;
         }
-    } else {
-        // Для нормальных моделей используем оригинал
-        instance.model = model;
-    }
-    instance.name = name ? name : "unnamed";
-    instance.x = x;
-    instance.y = y;
-    instance.z = z;
-    instance.rx = rx;
-    instance.ry = ry;
-    instance.rz = rz;
-    instance.rw = rw;
-    
-    // Инициализируем OpenGL объекты
-    instance.vao = 0;
-    instance.vbo = 0;
-    instance.normalVBO = 0;
-    instance.ebo = 0;
-    instance.indexCount = instance.model.polygons.size() * 3; // 3 индекса на треугольник
-    instance.normalCount = instance.model.normals.size();
-    instance.uploadedToGPU = false;
-    
-    // Добавляем модель в очередь - загрузим в GPU позже
-    m_dffModels.push_back(instance);
-    //printf("[Renderer] AddDffModel: модель '%s' добавлена в очередь (всего DFF моделей: %zu)\n", name, m_dffModels.size());
+    }
+    
+    // Модель попадает в реестр один раз, размещение хранит только ее дескриптор;
+    // загрузим в GPU позже, размещение - в ту же строку таблицы
+    m_dffRowModels.push_back(m_dffModelRegistry.Acquire(sceneModelKey, sceneModel));
+    uint32_t modelHandle = m_dffPlacements.InternModel(name ? name : "unnamed");
+    size_t row = m_dffPlacements.AddInstance(modelHandle, x, y, z, { rx, ry, rz, rw }, 0, lodParentKey);
+    ApplyModelDrawDistance(m_dffPlacements, modelHandle);
+    
+    // Строка доступна LOD-потомкам по своему ключу
+    if (lodKey >= 0) {
+        m_dffRowsByLodKey[lodKey] = static_cast<uint32_t>(row);
+    }
+    m_dffHighDetail.push_back(1);
+    m_dffLodFrame.push_back(0);
+    m_dffLodFlags.push_back(0);
+    //printf("[Renderer] AddDffModel: модель '%s' добавлена в очередь (всего DFF моделей: %zu)\n", name, m_dffRowModels.size());
 }
 // Методы для работы с IMG архивами
 void Renderer::SetImgArchives(const std::vector<img::ImgData*>& archives) {
@@ -1053,96 +1072,32 @@ void Renderer::LoadAllDffModelsToGPU() {
         return;
     }
     
-    //LogModels("LoadAllDffModelsToGPU: начинаем загрузку " + std::to_string(m_dffModels.size()) + " DFF моделей в GPU...");
+    //LogModels("LoadAllDffModelsToGPU: начинаем загрузку " + std::to_string(m_dffModelRegistry.GetModelCount()) + " уникальных DFF моделей в GPU...");
     
-    // Анализируем все модели перед загрузкой
-    size_t totalVertices = 0, totalPolygons = 0, totalNormals = 0;
-    size_t emptyModels = 0, modelsWithVerticesOnly = 0, modelsWithPolygonsOnly = 0;
-    
-    for (const auto& instance : m_dffModels) {
-        totalVertices += instance.model.vertices.size();
-        totalPolygons += instance.model.polygons.size();
-        totalNormals += instance.model.normals.size();
-        
-        if (instance.model.vertices.empty() && instance.model.polygons.empty()) {
-            emptyModels++;
-        } else if (instance.model.vertices.empty() && !instance.model.polygons.empty()) {
-            modelsWithPolygonsOnly++;
-        } else if (!instance.model.vertices.empty() && instance.model.polygons.empty()) {
-            modelsWithVerticesOnly++;
+    // Каждая уникальная модель загружается один раз, сколько бы размещений на нее ни ссылалось
+    std::vector<uint32_t> modelHandles;
+    m_dffModelRegistry.ForEach([&](uint32_t handle, const ModelRegistry::Entry& entry) {
+        if (!entry.uploadedToGPU) {
+            modelHandles.push_back(handle);
         }
-    }
-    
-
-    //LogModels("Общая статистика моделей:");
-    //LogModels("  - Всего вершин: " + std::to_string(totalVertices));
-    //LogModels("  - Всего полигонов: " + std::to_string(totalPolygons));
-    //LogModels("  - Всего нормалей: " + std::to_string(totalNormals));
-    //LogModels("  - Полностью пустых моделей: " + std::to_string(emptyModels));
-    //LogModels("  - Моделей только с вершинами: " + std::to_string(modelsWithVerticesOnly));
-    //LogModels("  - Моделей только с полигонами: " + std::to_string(modelsWithPolygonsOnly));
-    //LogModels("  - Моделей с полной геометрией: " + std::to_string(m_dffModels.size() - emptyModels - modelsWithVerticesOnly - modelsWithPolygonsOnly));
-    
-    // Если есть проблемные модели, показываем их детально
-    if (emptyModels > 0 || modelsWithVerticesOnly > 0 || modelsWithPolygonsOnly > 0) {
-        //LogWarning("⚠️  ОБНАРУЖЕНЫ ПРОБЛЕМНЫЕ МОДЕЛИ:");
-        //LogWarning("  - Полностью пустых: " + std::to_string(emptyModels));
-        //LogWarning("  - Только вершины: " + std::to_string(modelsWithVerticesOnly));
-        //LogWarning("  - Только полигоны: " + std::to_string(modelsWithPolygonsOnly));
-        //LogWarning("  - Всего проблемных: " + std::to_string(emptyModels + modelsWithVerticesOnly + modelsWithPolygonsOnly) + " из " + std::to_string(m_dffModels.size()) + " (" + 
-               //std::to_string((float)(emptyModels + modelsWithVerticesOnly + modelsWithPolygonsOnly) / m_dffModels.size() * 100.0f) + "%)");
-        
-        // Показываем информацию о fallback
-        //LogInfo("🔧 СИСТЕМА ИСПРАВЛЕНИЯ АКТИВНА:");
-        //LogInfo("  - Проблемные модели будут автоматически исправляться из unpack/");
-        //LogInfo("  - Путь: data/unpack/[имя_модели].dff");
-    }
-    
-    //LogModels("Начинаем загрузку в GPU...");
+    });
     
     int loadedCount = 0;
     int errorCount = 0;
     
-    for (auto& instance : m_dffModels) {
-        if (instance.uploadedToGPU) {
-            //LogModels("LoadAllDffModelsToGPU: модель '" + instance.name + "' уже загружена в GPU");
-            loadedCount++;
-            continue;
-        }
-        
-        if (instance.model.vertices.empty() || instance.model.polygons.empty()) {
-            //LogWarning("LoadAllDffModelsToGPU: модель '" + instance.name + "' не содержит геометрии");
-            //LogWarning("  - Вершины: " + std::to_string(instance.model.vertices.size()) + ", Полигоны: " + std::to_string(instance.model.polygons.size()) + ", Нормали: " + std::to_string(instance.model.normals.size()));
-            //LogWarning("  - Позиция: (" + std::to_string(instance.x) + ", " + std::to_string(instance.y) + ", " + std::to_string(instance.z) + ")");
-            
-            // Анализируем, что именно не так с моделью
-            if (instance.model.vertices.empty() && instance.model.polygons.empty()) {
-                //LogError("  - ❌ Модель полностью пустая (нет вершин и полигонов)");
-            } else if (instance.model.vertices.empty()) {
-                //LogError("  - ❌ Есть полигоны (" + std::to_string(instance.model.polygons.size()) + "), но нет вершин");
-            } else if (instance.model.polygons.empty()) {
-                //LogError("  - ❌ Есть вершины (" + std::to_string(instance.model.vertices.size()) + "), но нет полигонов");
-            }
-            
-            // Проверяем, есть ли нормали
-            if (instance.model.normals.empty()) {
-                //LogInfo("  - ℹ️  Нормали отсутствуют (будут сгенерированы)");
-            } else {
-                //LogInfo("  - ℹ️  Есть нормали (" + std::to_string(instance.model.normals.size()) + ")");
-            }
-            
+    for (uint32_t handle : modelHandles) {
+        const dff::DffModel& model = m_dffModelRegistry.GetModel(handle);
+        if (model.getVertexCount() == 0 || model.getPolygonCount() == 0) {
+            //LogWarning("LoadAllDffModelsToGPU: модель не содержит геометрии (вершины: " + std::to_string(model.getVertexCount()) + ", полигоны: " + std::to_string(model.getPolygonCount()) + ")");
             errorCount++;
             continue;
         }
         
-        //printf("[Renderer] LoadAllDffModelsToGPU: загружаем модель '%s' в GPU...\n", instance.name.c_str());
-        
-        if (UploadModelToGPU(instance)) {
+        if (UploadModelToGPU(handle)) {
             loadedCount++;
-            //printf("[Renderer] LoadAllDffModelsToGPU: модель '%s' успешно загружена в GPU\n", instance.name.c_str());
         } else {
             errorCount++;
-            //LogError("LoadAllDffModelsToGPU: ошибка загрузки модели '" + instance.name + "' в GPU");
+            //LogError("LoadAllDffModelsToGPU: ошибка загрузки модели в GPU");
         }
     }
     
@@ -1156,23 +1111,25 @@ void Renderer::LoadVisibleDffModelsToGPU() {
     }
     
     // Получаем видимые модели
-    const std::vector<DffModelInstance>& visibleModels = GetVisibleDffModels();
+    const std::vector<uint32_t>& visibleModels = GetVisibleDffModels();
     
     int loadedCount = 0;
     int errorCount = 0;
     
-    for (const auto& instance : visibleModels) {
-        if (instance.uploadedToGPU) {
-            continue; // Уже загружена
+    for (uint32_t row : visibleModels) {
+        const uint32_t modelHandle = m_dffRowModels[row];
+        if (m_dffModelRegistry.Get(modelHandle).uploadedToGPU) {
+            continue; // Уже загружена (в том числе другим размещением той же модели)
         }
         
-        if (instance.model.vertices.empty() || instance.model.polygons.empty()) {
+        const dff::DffModel& model = m_dffModelRegistry.GetModel(modelHandle);
+        if (model.getVertexCount() == 0 || model.getPolygonCount() == 0) {
             errorCount++;
             continue;
         }
         
         // Загружаем модель в GPU
-        if (UploadModelToGPU(const_cast<DffModelInstance&>(instance))) {
+        if (UploadModelToGPU(modelHandle)) {
             loadedCount++;
         } else {
             errorCount++;
@@ -1184,7 +1141,7 @@ void Renderer::LoadVisibleDffModelsToGPU() {
 
 void Renderer::RenderDffModels() {
     
-    if (m_dffModels.empty()) {
+    if (m_dffRowModels.empty()) {
         return;
     }
     
@@ -1192,7 +1149,8 @@ void Renderer::RenderDffModels() {
     static int renderLogCount = 0;
     renderLogCount++;
     if (renderLogCount % 180 == 0) { // Логируем каждые 180 кадров (примерно раз в 3 секунды)
-        LogRender("RenderDffModels: всего DFF моделей: " + std::to_string(m_dffModels.size()));
+        LogRender("RenderDffModels: всего DFF моделей: " + std::to_string(m_dffRowModels.size()) +
+                  " (уникальных " + std::to_string(m_dffModelRegistry.GetModelCount()) + ", в GPU " + std::to_string(m_dffModelRegistry.GetUploadedCount()) + ")");
     }
     
 
@@ -1234,34 +1192,36 @@ void Renderer::RenderDffModels() {
     
     // Находим максимальное количество полигонов среди всех моделей для нормализации
     int maxPolygons = 1;
-    for (const auto& instance : m_dffModels) {
-        maxPolygons = std::max(maxPolygons, static_cast<int>(instance.model.polygons.size()));
-    }
+    m_dffModelRegistry.ForEach([&](uint32_t, const ModelRegistry::Entry& entry) {
+        maxPolygons = std::max(maxPolygons, static_cast<int>(entry.model->getPolygonCount()));
+    });
     
     // Передаем максимальное количество полигонов в шейдер
     if (locMaxPolygons >= 0) glUniform1i(locMaxPolygons, maxPolygons);
     
     // Убираем статический цвет - теперь цвет будет вычисляться в шейдере на основе количества полигонов
 
+    // ПРОВЕРЯЕМ РАДИУС РЕНДЕРИНГА ДЛЯ DFF МОДЕЛЕЙ - по колонкам X/Y таблицы размещений,
+    // затем из каждой пары HD/LOD оставляем один уровень
+    QueryVisibleRows(m_dffPlacements, m_camera.GetX(), m_camera.GetY(), m_dffRowsInRadius);
+    SelectLodLevels(m_dffRowsInRadius, m_dffRowsToDraw);
+    
+    const std::vector<float>& placementX = m_dffPlacements.GetX();
+    const std::vector<float>& placementY = m_dffPlacements.GetY();
+    const std::vector<float>& placementZ = m_dffPlacements.GetZ();
+    const std::vector<SceneInstanceTable::Quaternion>& placementRotations = m_dffPlacements.GetRotations();
+    
     int renderedCount = 0;
-    int totalModels = static_cast<int>(m_dffModels.size());
-    int filteredModels = 0;
-    
-    // Отладочная информация о первых нескольких моделях
-    int debugCount = 0;
-    for (const auto& instance : m_dffModels) {
-        // ПРОВЕРЯЕМ РАДИУС РЕНДЕРИНГА ДЛЯ DFF МОДЕЛЕЙ
-        if (!IsObjectInRenderRadius(instance)) {
-            filteredModels++;
-            continue; // Пропускаем модели вне радиуса
-        }
+    int totalModels = static_cast<int>(m_dffRowModels.size());
+    int filteredModels = totalModels - static_cast<int>(m_dffRowsInRadius.size());
+    
+    for (uint32_t row : m_dffRowsToDraw) {
+        const uint32_t modelHandle = m_dffRowModels[row];
+        const ModelRegistry::Entry& instance = m_dffModelRegistry.Get(modelHandle);
         
-        if (debugCount < 3) {
-            debugCount++;
-        }
         // Загружаем модель в GPU если она не загружена
         if (!instance.uploadedToGPU) {
-            if (!UploadModelToGPU(const_cast<DffModelInstance&>(instance))) {
+            if (!UploadModelToGPU(modelHandle)) {
                 //LogRender("RenderDffModels: ошибка загрузки модели '" + instance.name + "' в GPU");
                 continue;
             }
@@ -1281,12 +1241,13 @@ void Renderer::RenderDffModels() {
 
 
         // Модельная матрица из позиции и кватерниона
+        const SceneInstanceTable::Quaternion& rotation = placementRotations[row];
         glm::mat4 model(1.0f);
-        model = glm::translate(model, glm::vec3(instance.x, instance.y, instance.z));
+        model = glm::translate(model, glm::vec3(placementX[row], placementY[row], placementZ[row]));
         
         // Применяем поворот
-        if (m_useQuaternions && (abs(instance.rx) > 0.001f || abs(instance.ry) > 0.001f || abs(instance.rz) > 0.001f || abs(instance.rw - 1.0f) > 0.001f)) {
-            float rx = instance.rx, ry = instance.ry, rz = instance.rz, rw = instance.rw;
+        if (m_useQuaternions && (abs(rotation.x) > 0.001f || abs(rotation.y) > 0.001f || abs(rotation.z) > 0.001f || abs(rotation.w - 1.0f) > 0.001f)) {
+            float rx = rotation.x, ry = rotation.y, rz = rotation.z, rw = rotation.w;
             float length = sqrtf(rx * rx + ry * ry + rz * rz + rw * rw);
             if (length > 0.0001f) {
                 rx /= length; ry /= length; rz /= length; rw /= length;
@@ -1307,11 +1268,11 @@ void Renderer::RenderDffModels() {
         if (locModel >= 0) glUniformMatrix4fv(locModel, 1, GL_FALSE, glm::value_ptr(model));
         
         // Передаем количество полигонов для этой конкретной модели
-        if (locPolygonCount >= 0) glUniform1i(locPolygonCount, static_cast<int>(instance.model.polygons.size()));
+        if (locPolygonCount >= 0) glUniform1i(locPolygonCount, static_cast<int>(instance.model->getPolygonCount()));
 
         // Рендерим реальную DFF модель используя её VAO/VBO
         glBindVertexArray(instance.vao);
-        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(instance.indexCount), GL_UNSIGNED_INT, 0);
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(instance.indexCount), instance.indexType, 0);
         glBindVertexArray(0);
         
         renderedCount++;
@@ -1323,6 +1284,7 @@ void Renderer::RenderDffModels() {
     if (logFrameCount % 60 == 0) { // Логируем каждые 60 кадров (примерно раз в секунду)
         LogRender("DFF рендеринг: всего " + std::to_string(totalModels) + 
                  ", отфильтровано по радиусу " + std::to_string(filteredModels) + 
+                 ", скрыто выбором LOD " + std::to_string(m_lodHiddenCount) + 
                  ", отрендерено " + std::to_string(renderedCount) + 
                  " (радиус: " + std::to_string(m_renderRadius) + ")");
     }
@@ -1330,58 +1292,121 @@ void Renderer::RenderDffModels() {
     glUseProgram(0);
 }
 
-// Методы фильтрации объектов по радиусу рендеринга
-bool Renderer::IsObjectInRenderRadius(const DffModelInstance& obj) const {
-    // Получаем позицию камеры
-    float camX = m_camera.GetX();
-    float camY = m_camera.GetY();
-    
-    // Вычисляем расстояние по X и Y (игнорируем Z)
-    float dx = obj.x - camX;
-    float dy = obj.y - camY;
-    float distanceSquared = dx * dx + dy * dy;
-    float distance = sqrt(distanceSquared);
-    
-    // Отладочная информация для первых нескольких DFF моделей
-    static int debugCount = 0;
-    if (debugCount < 5) {
-        LogRender("IsObjectInRenderRadius DFF: модель '" + obj.name + "' на расстоянии " + std::to_string(distance) + " от камеры (" + std::to_string(camX) + ", " + std::to_string(camY) + ")");
-        LogRender("  Позиция модели: (" + std::to_string(obj.x) + ", " + std::to_string(obj.y) + ")");
-        LogRender("  Рендер-радиус: " + std::to_string(m_renderRadius));
-        LogRender("  В радиусе: " + std::string(distance <= m_renderRadius ? "ДА" : "НЕТ"));
-        debugCount++;
-    }
-    
-    // Проверяем, находится ли объект в радиусе
-    return distanceSquared <= m_renderRadius * m_renderRadius;
+float Renderer::GetLodSwitchDistance(uint32_t row) const {
+    // HD модель сменяется LOD на границе своей дальности прорисовки (как в игре)
+    if (m_useModelDrawDistances && m_modelDefinitions) {
+        float drawDistance = m_dffPlacements.GetModel(m_dffPlacements.GetModelHandles()[row]).drawDistance;
+        if (drawDistance > 0.0f) {
+            return drawDistance;
+        }
+    }
+    return kDefaultLodSwitchDistance;
 }
 
-bool Renderer::IsObjectInRenderRadius(const ipl::IplObject& obj) const {
-    // Получаем позицию камеры
-    float camX = m_camera.GetX();
-    float camY = m_camera.GetY();
-    
-    // Вычисляем расстояние по X и Y (игнорируем Z)
-    float dx = obj.x - camX;
-    float dy = obj.y - camY;
-    float distanceSquared = dx * dx + dy * dy;
-    float distance = sqrt(distanceSquared);
-    
-    // Отладочная информация для первых нескольких объектов
-    static int debugCount = 0;
-    if (debugCount < 5) {
-        //LogRender("IsObjectInRenderRadius: объект '" + obj.name + "' на расстоянии " + std::to_string(distance) + " от камеры (" + std::to_string(camX) + ", " + std::to_string(camY) + ")");
-        //LogRender("  Позиция объекта: (" + std::to_string(obj.x) + ", " + std::to_string(obj.y) + ")");
-        //LogRender("  Рендер-радиус: " + std::to_string(m_renderRadius));
-        //LogRender("  В радиусе: " + std::string(distance <= m_renderRadius ? "ДА" : "НЕТ"));
-        debugCount++;
-    }
-    
-    // Проверяем, находится ли объект в радиусе
-    return distanceSquared <= m_renderRadius * m_renderRadius;
+void Renderer::SelectLodLevels(const std::vector<uint32_t>& candidates, std::vector<uint32_t>& rows) {
+    enum : uint8_t {
+        kCandidate = 1,     // Строка в радиусе в этом кадре
+        kHidden = 2         // Вместо строки рисуется другой уровень
+    };
+    
+    m_lodFrame++;
+    for (uint32_t row : candidates) {
+        m_dffLodFlags[row] |= kCandidate;
+    }
+    
+    const float cameraX = m_camera.GetX();
+    const float cameraY = m_camera.GetY();
+    const std::vector<int32_t>& parentKeys = m_dffPlacements.GetLods();
+    const std::vector<float>& placementX = m_dffPlacements.GetX();
+    const std::vector<float>& placementY = m_dffPlacements.GetY();
+    
+    for (uint32_t row : candidates) {
+        const bool seenLastFrame = m_dffLodFrame[row] + 1 == m_lodFrame;
+        m_dffLodFrame[row] = m_lodFrame;
+        
+        if (parentKeys[row] < 0) {
+            continue;
+        }
+        
+        // LOD-родитель еще не загружен или вне радиуса - HD рисуется сам по себе
+        auto parentIt = m_dffRowsByLodKey.find(parentKeys[row]);
+        if (parentIt == m_dffRowsByLodKey.end() || parentIt->second == row || !(m_dffLodFlags[parentIt->second] & kCandidate)) {
+            continue;
+        }
+        
+        // Гистерезис: HD -> LOD за дальностью переключения, LOD -> HD - только ближе нее на ширину полосы,
+        // поэтому камера на границе не вызывает мерцание уровней
+        const float switchDistance = GetLodSwitchDistance(row);
+        const float band = std::max(switchDistance * kLodHysteresisFraction, kLodHysteresisMin);
+        const float dx = placementX[row] - cameraX;
+        const float dy = placementY[row] - cameraY;
+        const float distance = std::sqrt(dx * dx + dy * dy);
+        
+        uint8_t& highDetail = m_dffHighDetail[row];
+        if (!seenLastFrame) {
+            // Строка только что вошла в радиус (или только что загружена) - решаем без истории
+            highDetail = distance < switchDistance - band ? 1 : 0;
+        }
+        else if (highDetail && distance > switchDistance) {
+            highDetail = 0;
+        }
+        else if (!highDetail && distance < switchDistance - band) {
+            highDetail = 1;
+        }
+        
+        m_dffLodFlags[highDetail ? parentIt->second : row] |= kHidden;
+    }
+    
+    rows.clear();
+    m_lodHiddenCount = 0;
+    for (uint32_t row : candidates) {
+        if (m_dffLodFlags[row] & kHidden) {
+            m_lodHiddenCount++;
+        }
+        else {
+            rows.push_back(row);
+        }
+    }
+    for (uint32_t row : candidates) {
+        m_dffLodFlags[row] = 0;
+    }
 }
 
-const std::vector<Renderer::DffModelInstance>& Renderer::GetVisibleDffModels() const {
+void Renderer::SetModelDefinitions(const ide::IdeData* definitions) {
+    m_modelDefinitions = definitions;
+    ApplyModelDrawDistances(m_gtaObjects);
+    ApplyModelDrawDistances(m_dffPlacements);
+    m_cameraMoved = true;
+}
+
+void Renderer::ApplyModelDrawDistance(SceneInstanceTable& table, uint32_t modelHandle) {
+    const SceneInstanceTable::ModelRecord& record = table.GetModel(modelHandle);
+    const ide::ObjectDefinition* definition = nullptr;
+    if (m_modelDefinitions) {
+        definition = record.modelId >= 0 ? m_modelDefinitions->findById(record.modelId) : nullptr;
+        if (!definition) {
+            definition = m_modelDefinitions->findByName(record.name);
+        }
+    }
+    table.SetModelDrawDistance(modelHandle, definition ? definition->drawDistance : 0.0f);
+}
+
+void Renderer::ApplyModelDrawDistances(SceneInstanceTable& table) {
+    for (uint32_t handle = 0; handle < table.GetModelCount(); handle++) {
+        ApplyModelDrawDistance(table, handle);
+    }
+}
+
+void Renderer::QueryVisibleRows(const SceneInstanceTable& table, float cameraX, float cameraY, std::vector<uint32_t>& rows) const {
+    if (m_useModelDrawDistances && m_modelDefinitions) {
+        table.QueryDrawDistance(cameraX, cameraY, m_renderRadius, rows);
+    }
+    else {
+        table.QueryRadius(cameraX, cameraY, m_renderRadius, rows);
+    }
+}
+
+const std::vector<uint32_t>& Renderer::GetVisibleDffModels() const {
     // Проверяем, сдвинулась ли камера или принудительно обновляем
     float currentCamX = m_camera.GetX();
     float currentCamY = m_camera.GetY();
@@ -1392,26 +1417,16 @@ const std::vector<Renderer::DffModelInstance>& Renderer::GetVisibleDffModels() c
         m_lastCameraY = currentCamY;
         m_cameraMoved = false; // Сбрасываем флаг
         
-        // Очищаем и пересчитываем кэш
-        m_visibleDffModels.clear();
-
-        for (const auto& model : m_dffModels) {
-            if (IsObjectInRenderRadius(model)) {
-                m_visibleDffModels.push_back(model);
-                //LogRender("GetVisibleDffModels: модель '" + model.name + "' В РАДИУСЕ (" + std::to_string(model.x) + ", " + std::to_string(model.y) + ")");
-            } else {
-                float distance = sqrt((model.x - currentCamX) * (model.x - currentCamX) + (model.y - currentCamY) * (model.y - currentCamY));
-                //LogRender("GetVisibleDffModels: модель '" + model.name + "' ВНЕ РАДИУСА (" + std::to_string(model.x) + ", " + std::to_string(model.y) + ") - расстояние: " + std::to_string(distance) + " > " + std::to_string(m_renderRadius));
-            }
-        }
+        // Пересчитываем кэш: читаются только колонки X и Y таблицы размещений
+        QueryVisibleRows(m_dffPlacements, currentCamX, currentCamY, m_visibleDffModels);
         
         // Логируем статистику фильтрации
         static int filterLogCount = 0;
         filterLogCount++;
         if (filterLogCount % 120 == 0) { // Логируем каждые 120 кадров (примерно раз в 2 секунды)
-            LogRender("Фильтрация DFF моделей: всего " + std::to_string(m_dffModels.size()) + 
+            LogRender("Фильтрация DFF моделей: всего " + std::to_string(m_dffRowModels.size()) + 
                      ", видимых " + std::to_string(m_visibleDffModels.size()) + 
-                     ", отфильтровано " + std::to_string(m_dffModels.size() - m_visibleDffModels.size()) + 
+                     ", отфильтровано " + std::to_string(m_dffRowModels.size() - m_visibleDffModels.size()) + 
                      " (радиус: " + std::to_string(m_renderRadius) + ")");
         }
 
@@ -1420,7 +1435,7 @@ const std::vector<Renderer::DffModelInstance>& Renderer::GetVisibleDffModels() c
     return m_visibleDffModels;
 }
 
-const std::vector<ipl::IplObject>& Renderer::GetVisibleGtaObjects() const {
+const std::vector<uint32_t>& Renderer::GetVisibleGtaObjects() const {
     // Проверяем, сдвинулась ли камера или принудительно обновляем
     float currentCamX = m_camera.GetX();
     float currentCamY = m_camera.GetY();
@@ -1431,22 +1446,8 @@ const std::vector<ipl::IplObject>& Renderer::GetVisibleGtaObjects() const {
         m_lastCameraY = currentCamY;
         m_cameraMoved = false; // Сбрасываем флаг
         
-        // Очищаем и пересчитываем кэш
-        m_visibleGtaObjects.clear();
-        
-
-        
-        for (const auto& obj : m_gtaObjects) {
-            if (IsObjectInRenderRadius(obj)) {
-                m_visibleGtaObjects.push_back(obj);
-               // //LogRender("GetVisibleGtaObjects: объект '" + obj.name + "' В РАДИУСЕ (" + std::to_string(obj.x) + ", " + std::to_string(obj.y) + ")");
-            } else {
-               // float distance = sqrt((obj.x - currentCamX) * (obj.x - currentCamX) + (obj.y - currentCamY) * (obj.y - currentCamY));
-              //  //LogRender("GetVisibleGtaObjects: объект '" + obj.name + "' ВНЕ РАДИУСА (" + std::to_string(obj.x) + ", " + std::to_string(obj.y) + ") - расстояние: " + std::to_string(distance) + " > " + std::to_string(m_renderRadius));
-            }
-        }
-        
-
+        // Пересчитываем кэш: читаются только колонки X и Y таблицы объектов
+        QueryVisibleRows(m_gtaObjects, currentCamX, currentCamY, m_visibleGtaObjects);
     }
     
     return m_visibleGtaObjects;
@@ -1456,21 +1457,15 @@ const std::vector<ipl::IplObject>& Renderer::GetVisibleGtaObjects() const {
 // MODERN OPENGL IMPLEMENTATION (VBO/VAO)
 // ============================================================================
 
-bool Renderer::UploadModelToGPU(DffModelInstance& instance) {
-    // Создаем не-const копию модели для вызова loadToGPU
-    dff::DffModel& model = const_cast<dff::DffModel&>(instance.model);
-    
-    //printf("[Renderer] UploadModelToGPU: начинаем загрузку модели '%s' в GPU\n", instance.name.c_str());
+bool Renderer::UploadModelToGPU(uint32_t modelHandle) {
+    const dff::DffModel& model = m_dffModelRegistry.GetModel(modelHandle);
     
-    if (model.vertices.empty() || model.polygons.empty()) {
-        //LogWarning("UploadModelToGPU: модель '" + instance.name + "' не содержит геометрии - ПРОПУСКАЕМ");
-        //LogWarning("  - Вершины: " + std::to_string(model.vertices.size()) + ", Полигоны: " + std::to_string(model.polygons.size()) + ", Нормали: " + std::to_string(model.normals.size()));
+    if (model.getVertexCount() == 0 || model.getPolygonCount() == 0) {
+        //LogWarning("UploadModelToGPU: модель не содержит геометрии - ПРОПУСКАЕМ");
         return false;
     }
     
-    //LogRender("UploadModelToGPU: модель '" + instance.name + "' содержит " + std::to_string(model.vertices.size()) + " вершин и " + std::to_string(model.polygons.size()) + " полигонов");
-    
-    //printf("[Renderer] UploadModelToGPU: модель '%s' содержит %zu вершин и %zu полигонов\n", instance.name.c_str(), model.vertices.size(), model.polygons.size());
+    //printf("[Renderer] UploadModelToGPU: модель содержит %zu вершин и %zu полигонов\n", model.getVertexCount(), model.getPolygonCount());
     
     // Без текущего контекста OpenGL буферы создавать нельзя
     if (!m_initialized || !m_window || glfwGetCurrentContext() == nullptr) {
@@ -1478,163 +1473,80 @@ bool Renderer::UploadModelToGPU(DffModelInstance& instance) {
         return false;
     }
     
-    //printf("[Renderer] UploadModelToGPU: OpenGL готов, используем метод loadToGPU() из DffModel...\n");
-    
-    // Используем наш метод loadToGPU() из DffModel
-    if (model.loadToGPU()) {
-        //LogRender("UploadModelToGPU: модель '" + instance.name + "' успешно загружена в GPU через DffModel::loadToGPU()");
-        
-        // Копируем OpenGL объекты из DffModel в instance
-        instance.vao = model.vao;
-        instance.vbo = model.vbo;
-        instance.ebo = model.ebo;
-        instance.uploadedToGPU = true;
-        
-        //LogRender("UploadModelToGPU: скопированы OpenGL объекты - VAO=" + std::to_string(instance.vao) + ", VBO=" + std::to_string(instance.vbo) + ", EBO=" + std::to_string(instance.ebo));
-        
-        return true;
-    } else {
-        //LogError("UploadModelToGPU: ОШИБКА - DffModel::loadToGPU() не удался для модели '" + instance.name + "'");
-        return false;
-    }
-}
-
-void Renderer::DeleteModelFromGPU(DffModelInstance& instance) {
-    //LogRender("DeleteModelFromGPU: удаляем модель '" + instance.name + "' из GPU");
-    //LogRender("  - Удаляем VAO: " + std::to_string(instance.vao) + ", VBO: " + std::to_string(instance.vbo) + ", NormalVBO: " + std::to_string(instance.normalVBO) + ", EBO: " + std::to_string(instance.ebo));
-    
-    if (instance.vao != 0) {
-        glDeleteVertexArrays(1, &instance.vao);
-        instance.vao = 0;
-    }
-    
-    if (instance.vbo != 0) {
-        glDeleteBuffers(1, &instance.vbo);
-        instance.vbo = 0;
-    }
-    
-    if (instance.normalVBO != 0) {
-        glDeleteBuffers(1, &instance.normalVBO);
-        instance.normalVBO = 0;
-    }
-    
-    if (instance.ebo != 0) {
-        glDeleteBuffers(1, &instance.ebo);
-        instance.ebo = 0;
-    }
-    
-    instance.uploadedToGPU = false;
-    instance.indexCount = 0;
-    //LogRender("DeleteModelFromGPU: модель '" + instance.name + "' удалена из GPU");
+    // Буферы создаются один раз на модель и разделяются всеми ее размещениями
+    return m_dffModelRegistry.Upload(modelHandle);
 }
 
 void Renderer::CleanupAllGPUModels() {
     //printf("[Renderer] Очистка всех GPU моделей...\n");
     
-    for (auto& instance : m_dffModels) {
-        if (instance.uploadedToGPU) {
-            DeleteModelFromGPU(instance);
-        }
-    }
+    m_dffModelRegistry.DeleteAllFromGPU();
     
     //printf("[Renderer] Все GPU модели очищены\n");
 }
 
-// Fallback метод для загрузки проблемных моделей из распакованных файлов
-dff::DffModel Renderer::LoadDffFromUnpack(const std::string& modelName) {
-    // Формируем путь к распакованному файлу
-    std::string unpackPath = "unpack\\" + modelName + ".dff";
-    
-    // Проверяем существование файла
-    FILE* file = fopen(unpackPath.c_str(), "rb");
-    if (!file) {
-        // Пытаемся извлечь модель из IMG архива
-        if (ExtractModelFromImg(modelName, unpackPath)) {
-            // Теперь пытаемся открыть извлеченный файл
-            file = fopen(unpackPath.c_str(), "rb");
-            if (!file) {
-                return dff::DffModel(); // Возвращаем пустую модель
-            }
-        } else {
-            return dff::DffModel(); // Возвращаем пустую модель
-        }
-    }
-    
-    // Получаем размер файла
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-    
-    if (fileSize <= 0) {
-        fclose(file);
-        return dff::DffModel();
-    }
-    
-    // Читаем файл в буфер
-    std::vector<uint8_t> fileData(fileSize);
-    size_t bytesRead = fread(fileData.data(), 1, fileSize, file);
-    fclose(file);
-    
-    if (bytesRead != static_cast<size_t>(fileSize)) {
-        return dff::DffModel();
-    }
-    
-    // Пытаемся загрузить DFF из буфера
-    dff::DffData dffData;
-    if (dff::loadDffFromBuffer(fileData, dffData, modelName.c_str())) {
-        const dff::DffModel& model = dffData.getModel();
-        return model;
-    } else {
-        return dff::DffModel();
-    }
+void Renderer::ClearDffModels() {
+    // Каждое размещение держит ссылку на модель: с последней ссылкой модель покидает GPU и реестр
+    for (uint32_t modelHandle : m_dffRowModels) {
+        m_dffModelRegistry.Release(modelHandle);
+    }
+    m_dffModelRegistry.Clear();
+    
+    m_dffRowModels.clear();
+    m_dffPlacements.Clear();
+    m_dffRowsByLodKey.clear();
+    m_dffHighDetail.clear();
+    m_dffLodFrame.clear();
+    m_dffLodFlags.clear();
+    m_visibleDffModels.clear();
+    m_dffRowsInRadius.clear();
+    m_dffRowsToDraw.clear();
+    m_lodHiddenCount = 0;
 }
 
-// Функция для извлечения модели из IMG архива в файл
-bool Renderer::ExtractModelFromImg(const std::string& modelName, const std::string& outputPath) {
-    // Создаем папку unpack, если её нет
-    system("mkdir unpack 2>nul");
-    
-    if (m_imgArchives.empty()) {
-        return false;
+// Fallback метод для проблемных моделей: DFF из папки unpack, иначе из IMG
+std::shared_ptr<const dff::DffModel> Renderer::LoadFallbackDff(const std::string& modelName, uint64_t& assetKey) {
+    // Имена, для которых исправить модель уже не удалось, повторно не ищем
+    UnpackIndex& unpack = AssetCache::Unpack();
+    if (unpack.IsMissing(modelName)) {
+        return nullptr;
     }
     
-    try {
-        // Добавляем расширение .dff, если его нет
+    // Файл из папки unpack (по индексу каталога), иначе байты модели прямо из IMG -
+    // во временный файл ничего не пишется. Кэш - по пути файла или по записи IMG, как у стримера
+    std::shared_ptr<const dff::DffModel> model;
+    std::string unpackPath = unpack.FindModel(modelName);
+    if (!unpackPath.empty()) {
+        assetKey = AssetCache::MakeFileKey(unpackPath);
+        model = AssetCache::LoadDffFile(unpackPath);
+    }
+    else if (m_assetIndex) {
         std::string dffFileName = modelName;
         if (dffFileName.find(".dff") == std::string::npos) {
             dffFileName += ".dff";
         }
         
-        // Ищем модель в IMG архивах
-        if (!img::modelExists(m_imgArchives, dffFileName)) {
-            return false;
-        }
-        
-        // Получаем данные модели из IMG
-        std::vector<uint8_t> modelData = img::getModelData(m_imgArchives, dffFileName);
-        
-        if (modelData.empty()) {
-            return false;
-        }
-        
-        // Сохраняем данные в файл
-        FILE* outputFile = fopen(outputPath.c_str(), "wb");
-        if (!outputFile) {
-            return false;
-        }
-        
-        size_t written = fwrite(modelData.data(), 1, modelData.size(), outputFile);
-        fclose(outputFile);
-        
-        if (written != modelData.size()) {
-            return false;
+        if (const img::AssetIndex::Entry* indexEntry = m_assetIndex->find(dffFileName)) {
+            img::AssetIndex::ContentRef content = m_assetIndex->getContent(*indexEntry);
+            const uint64_t cacheKey = AssetCache::MakeKey(content.archive, content.entry);
+            assetKey = cacheKey;
+            model = AssetCache::Models().Find(cacheKey);
+            if (!model) {
+                std::span<const uint8_t> modelData = m_assetIndex->getContentArchive(*indexEntry)->getFileViewByIndex(content.entry);
+                dff::DffData dffData;
+                if (!modelData.empty() && dff::loadDffFromBuffer(modelData, dffData, modelName.c_str())) {
+                    model = std::make_shared<const dff::DffModel>(dffData.getModel());
+                    AssetCache::Models().Insert(cacheKey, model, AssetCache::EstimateBytes(*model));
+                }
+            }
         }
-        
-        return true;
-        
-    } catch (const std::exception& e) {
-        return false;
     }
+    
+    if (!model || model->getPolygonCount() == 0) {
+        unpack.MarkMissing(modelName);
+        return nullptr;
+    }
+    return model;
 }
 
 // ============================================================================
@@ -1934,39 +1846,42 @@ bool Renderer::DumpGeometryToFile(const std::string& filename) {
     file.write(fileSignature, 12);
     
     // Записываем количество моделей (uint32_t, little-endian)
-    uint32_t modelCount = static_cast<uint32_t>(m_dffModels.size());
+    uint32_t modelCount = static_cast<uint32_t>(m_dffRowModels.size());
     file.write(reinterpret_cast<const char*>(&modelCount), sizeof(uint32_t));
     
     LogRender("Начинаем дамп " + std::to_string(modelCount) + " моделей в файл " + filename);
     
-    // Дамп каждой модели
-    for (const auto& instance : m_dffModels) {
+    // Дамп каждой модели (имя и размещение - из колонок таблицы размещений)
+    for (size_t row = 0; row < m_dffRowModels.size(); row++) {
+        
         // Записываем длину названия модели (uint32_t)
-        uint32_t nameLength = static_cast<uint32_t>(instance.name.length());
+        const std::string& name = m_dffPlacements.GetModelName(row);
+        uint32_t nameLength = static_cast<uint32_t>(name.length());
         file.write(reinterpret_cast<const char*>(&nameLength), sizeof(uint32_t));
         
         // Записываем название модели
-        file.write(instance.name.c_str(), nameLength);
+        file.write(name.c_str(), nameLength);
         
         // Записываем координаты модели (7 float, little-endian)
-        file.write(reinterpret_cast<const char*>(&instance.x), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.y), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.z), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.rx), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.ry), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.rz), sizeof(float));
-        file.write(reinterpret_cast<const char*>(&instance.rw), sizeof(float));
+        const SceneInstanceTable::Quaternion& rotation = m_dffPlacements.GetRotations()[row];
+        file.write(reinterpret_cast<const char*>(&m_dffPlacements.GetX()[row]), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&m_dffPlacements.GetY()[row]), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&m_dffPlacements.GetZ()[row]), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&rotation.x), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&rotation.y), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&rotation.z), sizeof(float));
+        file.write(reinterpret_cast<const char*>(&rotation.w), sizeof(float));
         
         // Записываем количество треугольников (uint32_t)
-        const auto& model = instance.model;
-        uint32_t triangleCount = static_cast<uint32_t>(model.polygons.size());
+        const auto& model = m_dffModelRegistry.GetModel(m_dffRowModels[row]);
+        uint32_t triangleCount = static_cast<uint32_t>(model.getPolygonCount());
         file.write(reinterpret_cast<const char*>(&triangleCount), sizeof(uint32_t));
         
-        // Записываем треугольники (каждый треугольник = 9 float, little-endian)
-        for (const auto& polygon : model.polygons) {
-            const auto& v1 = model.vertices[polygon.vertex1];
-            const auto& v2 = model.vertices[polygon.vertex2];
-            const auto& v3 = model.vertices[polygon.vertex3];
+        // Записываем треугольники (каждый треугольник = 9 float, little-endian) из упакованных буферов
+        for (uint32_t triangle = 0; triangle < triangleCount; triangle++) {
+            const auto& v1 = model.gpuVertices[model.getGpuIndex(triangle * 3 + 0)];
+            const auto& v2 = model.gpuVertices[model.getGpuIndex(triangle * 3 + 1)];
+            const auto& v3 = model.gpuVertices[model.getGpuIndex(triangle * 3 + 2)];
             
             // Вершина 1
             file.write(reinterpret_cast<const char*>(&v1.x), sizeof(float));
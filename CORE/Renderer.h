@@ -7,6 +7,7 @@
 // Сначала стандартные библиотеки
 #include <string>
 #include <vector>
+#include <map>
 #include <algorithm> // Для std::sort
 
 // GLEW ДОЛЖЕН быть первым OpenGL заголовком!
@@ -41,6 +42,12 @@
 // Collision system
 #include "CollisionGtaSaParser.h"
 
+// Scene instances (SoA)
+#include "SceneInstances.h"
+
+// Реестр уникальных DFF моделей
+#include "ModelRegistry.h"
+
 
 
 // Windows API для диалога выбора файла
@@ -60,26 +67,6 @@
 
 class Renderer {
 public:
-    // Структура для DFF модели (должна быть объявлена до использования)
-    struct DffModelInstance {
-        dff::DffModel model;
-        std::string name;
-        float x, y, z;
-        float rx, ry, rz, rw;
-        
-        // Современный OpenGL: VBO/VAO вместо Display Lists
-        GLuint vao, vbo, ebo;  // Vertex Array Object, Vertex Buffer Object, Element Buffer Object
-        GLuint normalVBO;      // VBO для нормалей (если есть)
-        bool uploadedToGPU;
-        size_t indexCount;      // Количество индексов для рендеринга
-        size_t normalCount;     // Количество нормалей
-        
-        // Конструктор по умолчанию
-        DffModelInstance() : vao(0), vbo(0), ebo(0), normalVBO(0), uploadedToGPU(false), indexCount(0), normalCount(0) {}
-    };
-    
-
-    
     Renderer();
     ~Renderer();
     
@@ -111,6 +98,9 @@ public:
     
     // Геттеры камеры
     float GetCameraFOV() const { return m_camera.GetFOV(); }
+    float GetCameraX() const { return m_camera.GetX(); }
+    float GetCameraY() const { return m_camera.GetY(); }
+    float GetCameraZ() const { return m_camera.GetZ(); }
     
     // Геттеры статистики
     int GetTotalVertices() const { return m_totalVertices; }
@@ -119,10 +109,12 @@ public:
     int GetDffPolygons() const { return m_dffPolygons; }
     int GetSkyboxVertices() const { return m_skyboxVertices; }
     int GetSkyboxPolygons() const { return m_skyboxPolygons; }
-    int GetGtaObjectCount() const { return static_cast<int>(m_gtaObjects.size()); }
-    int GetDffModelCount() const { return static_cast<int>(m_dffModels.size()); }
+    int GetGtaObjectCount() const { return static_cast<int>(m_gtaObjects.Size()); }
+    int GetDffModelCount() const { return static_cast<int>(m_dffRowModels.size()); }
+    int GetUniqueDffModelCount() const { return static_cast<int>(m_dffModelRegistry.GetModelCount()); }
     int GetVisibleGtaObjectCount() const { return static_cast<int>(m_visibleGtaObjects.size()); }
     int GetVisibleDffModelCount() const { return static_cast<int>(m_visibleDffModels.size()); }
+    int GetLodHiddenCount() const { return m_lodHiddenCount; }
     
     // Геттеры/сеттеры настроек рендеринга
     bool IsUsingQuaternions() const { return m_useQuaternions; }
@@ -131,29 +123,44 @@ public:
     // Радиус рендеринга
     float GetRenderRadius() const { return m_renderRadius; }
     void SetRenderRadius(float radius) { m_renderRadius = radius; }
+    
+    // Дальность прорисовки моделей из IDE (радиус рендеринга остается верхней границей)
+    void SetModelDefinitions(const ide::IdeData* definitions);
+    bool IsUsingModelDrawDistances() const { return m_useModelDrawDistances; }
+    void SetUseModelDrawDistances(bool use) { m_useModelDrawDistances = use; m_cameraMoved = true; }
 
     
-    // Методы для работы с DFF моделями
-    void AddDffModel(const dff::DffModel& model, const char* name, float x, float y, float z, float rx, float ry, float rz, float rw);
+    // Методы для работы с DFF моделями.
+    // lodKey - ключ размещения в иерархии LOD, lodParentKey - ключ его LOD-родителя (-1 - нет):
+    // из пары HD/LOD в кадре рисуется ровно один уровень, выбранный по расстоянию до камеры
+    // Модель не копируется: размещение ссылается на общую геометрию через реестр моделей.
+    // assetKey - ключ модели в кэше ассетов (AssetCache::MakeKey / MakeFileKey)
+    void AddDffModel(uint64_t assetKey, const std::shared_ptr<const dff::DffModel>& model, const char* name, float x, float y, float z,
+                     float rx, float ry, float rz, float rw, int lodKey = -1, int lodParentKey = -1);
     void RenderDffModels();
     void LoadAllDffModelsToGPU();
     void LoadVisibleDffModelsToGPU(); // Загружать только видимые модели
+    void ClearDffModels();            // Отпустить все размещения и модели (нужен текущий контекст OpenGL)
 
     // Методы для работы с IMG архивами
     void SetImgArchives(const std::vector<img::ImgData*>& archives);
     void ClearImgArchives();
+    void SetAssetIndex(const img::AssetIndex* assetIndex) { m_assetIndex = assetIndex; }
     
     // Методы для работы с GTA объектами
     void SetGtaObjects(const std::vector<ipl::IplObject>& objects);
     void AddGtaObject(const ipl::IplObject& object);
     void AddTestObject(int index, int modelId, const char* name, float x, float y, float z, float rx, float ry, float rz, float rw);
     
-    // Методы для получения видимых объектов
-    const std::vector<DffModelInstance>& GetVisibleDffModels() const;
-    const std::vector<ipl::IplObject>& GetVisibleGtaObjects() const;
+    // Методы для получения видимых объектов (индексы строк m_dffPlacements / m_gtaObjects)
+    const std::vector<uint32_t>& GetVisibleDffModels() const;
+    const std::vector<uint32_t>& GetVisibleGtaObjects() const;
     
     // Методы для получения всех объектов
-    const std::vector<DffModelInstance>& GetAllDffModels() const { return m_dffModels; }
+    const ModelRegistry& GetDffModelRegistry() const { return m_dffModelRegistry; }
+    uint32_t GetDffRowModel(size_t row) const { return m_dffRowModels[row]; }
+    const SceneInstanceTable& GetDffPlacements() const { return m_dffPlacements; }
+    const SceneInstanceTable& GetGtaObjects() const { return m_gtaObjects; }
     
     // Методы для статистики
     void ResetRenderStats();
@@ -197,18 +204,31 @@ private:
     Camera m_camera;
     
     // GTA объекты
-    std::vector<ipl::IplObject> m_gtaObjects;
-    
-    // DFF модели
-    std::vector<DffModelInstance> m_dffModels;
+    SceneInstanceTable m_gtaObjects;
+    
+    // DFF модели: уникальная геометрия и GPU ресурсы - в реестре, размещения - в таблице
+    // (строка i таблицы ссылается на модель m_dffRowModels[i]).
+    // Колонка LOD таблицы размещений хранит ключ LOD-родителя строки.
+    ModelRegistry m_dffModelRegistry;
+    std::vector<uint32_t> m_dffRowModels;
+    SceneInstanceTable m_dffPlacements;
+    
+    // Иерархия LOD: ключ размещения -> строка, состояние выбора уровня у HD строк
+    std::map<int, uint32_t> m_dffRowsByLodKey;
+    std::vector<uint8_t> m_dffHighDetail;       // 1 - рисуется HD, 0 - рисуется LOD-родитель
+    std::vector<uint32_t> m_dffLodFrame;        // Кадр, в котором строка последний раз была в радиусе
+    std::vector<uint8_t> m_dffLodFlags;         // Временные пометки строк в SelectLodLevels
+    std::vector<uint32_t> m_dffRowsInRadius;    // Строки в радиусе отрисовки (буфер кадра, память переиспользуется)
+    std::vector<uint32_t> m_dffRowsToDraw;      // Строки после выбора уровня LOD (буфер кадра)
     
 
     // IMG архивы для извлечения моделей
     std::vector<img::ImgData*> m_imgArchives;
+    const img::AssetIndex* m_assetIndex = nullptr;  // Индекс имен по архивам (fallback моделей из IMG)
     
-    // Кэш видимых объектов (обновляется каждый кадр)
-    mutable std::vector<DffModelInstance> m_visibleDffModels;
-    mutable std::vector<ipl::IplObject> m_visibleGtaObjects;
+    // Кэш видимых объектов - индексы строк (обновляется при сдвиге камеры)
+    mutable std::vector<uint32_t> m_visibleDffModels;
+    mutable std::vector<uint32_t> m_visibleGtaObjects;
     
     // Кэш позиции камеры для оптимизации фильтрации
     mutable float m_lastCameraX, m_lastCameraY;
@@ -227,6 +247,14 @@ private:
     
     // Радиус рендеринга
     float m_renderRadius;
+    
+    // Определения моделей из IDE (не владеет) и режим отсечения по их дальности
+    const ide::IdeData* m_modelDefinitions;
+    bool m_useModelDrawDistances;
+    
+    // Счетчик кадров выбора уровня LOD и его результат
+    uint32_t m_lodFrame;
+    int m_lodHiddenCount;                       // Скрыто выбором уровня в последнем кадре
 
     
     // Отладочные флаги
@@ -244,20 +272,25 @@ private:
     // Вспомогательные методы
     void ProcessInput();
     
-    // Методы фильтрации объектов
-    bool IsObjectInRenderRadius(const DffModelInstance& obj) const;
-    bool IsObjectInRenderRadius(const ipl::IplObject& obj) const;
+    // Дальность прорисовки модели таблицы по определению из IDE (по ID, иначе по имени)
+    void ApplyModelDrawDistance(SceneInstanceTable& table, uint32_t modelHandle);
+    void ApplyModelDrawDistances(SceneInstanceTable& table);
+    
+    // Видимые строки таблицы: по дальности моделей или по общему радиусу
+    void QueryVisibleRows(const SceneInstanceTable& table, float cameraX, float cameraY, std::vector<uint32_t>& rows) const;
+    
+    // Выбрать уровень детализации: из строк в радиусе оставить по одному уровню на пару HD/LOD
+    void SelectLodLevels(const std::vector<uint32_t>& candidates, std::vector<uint32_t>& rows);
+    float GetLodSwitchDistance(uint32_t row) const;
     
     // Методы для современного OpenGL (VBO/VAO)
-    bool UploadModelToGPU(DffModelInstance& instance);
-    void DeleteModelFromGPU(DffModelInstance& instance);
+    bool UploadModelToGPU(uint32_t modelHandle);
     void CleanupAllGPUModels();
     
 
     
     // Fallback методы для проблемных моделей
-    dff::DffModel LoadDffFromUnpack(const std::string& modelName);
-    bool ExtractModelFromImg(const std::string& modelName, const std::string& outputPath);
+    std::shared_ptr<const dff::DffModel> LoadFallbackDff(const std::string& modelName, uint64_t& assetKey);
     
     // --- Grid (modern OpenGL) ---
     bool CreateGridResources();
@@ -0,0 +1,117 @@
+#include "SceneInstances.h"
+
+uint32_t SceneInstanceTable::InternModel(std::string_view name, int modelId) {
+    auto it = m_modelIndex.find(name);
+    if (it != m_modelIndex.end()) {
+        // ID мог быть неизвестен при первом добавлении
+        ModelRecord& record = m_models[it->second];
+        if (record.modelId < 0) {
+            record.modelId = modelId;
+        }
+        return it->second;
+    }
+
+    uint32_t handle = static_cast<uint32_t>(m_models.size());
+    m_models.push_back({ std::string(name), modelId, 0.0f });
+    m_modelIndex.emplace(std::string(name), handle);
+    return handle;
+}
+
+uint32_t SceneInstanceTable::FindModel(std::string_view name) const {
+    auto it = m_modelIndex.find(name);
+    return it != m_modelIndex.end() ? it->second : kInvalidModel;
+}
+
+size_t SceneInstanceTable::AddInstance(uint32_t model, float x, float y, float z, const Quaternion& rotation, int interior, int lod) {
+    m_x.push_back(x);
+    m_y.push_back(y);
+    m_z.push_back(z);
+    m_rotations.push_back(rotation);
+    m_modelHandles.push_back(model);
+    m_interiors.push_back(interior);
+    m_lods.push_back(lod);
+    return m_x.size() - 1;
+}
+
+size_t SceneInstanceTable::AddIplObject(const ipl::IplObject& object) {
+    return AddInstance(InternModel(object.name, object.modelId), object.x, object.y, object.z,
+                       { object.rx, object.ry, object.rz, object.rw }, object.interior, object.lod);
+}
+
+void SceneInstanceTable::AddIplObjects(const std::vector<ipl::IplObject>& objects) {
+    Reserve(Size() + objects.size());
+    for (const auto& object : objects) {
+        AddIplObject(object);
+    }
+}
+
+ipl::IplObject SceneInstanceTable::GetIplObject(size_t index) const {
+    const ModelRecord& model = m_models[m_modelHandles[index]];
+    const Quaternion& rotation = m_rotations[index];
+    return ipl::IplObject(model.modelId, model.name, m_interiors[index], m_x[index], m_y[index], m_z[index],
+                          rotation.x, rotation.y, rotation.z, rotation.w, m_lods[index]);
+}
+
+void SceneInstanceTable::QueryRadius(float centerX, float centerY, float radius, std::vector<uint32_t>& indices) const {
+    indices.clear();
+
+    const float radiusSq = radius * radius;
+    const float* xs = m_x.data();
+    const float* ys = m_y.data();
+    const size_t count = m_x.size();
+    for (size_t i = 0; i < count; i++) {
+        float dx = xs[i] - centerX;
+        float dy = ys[i] - centerY;
+        if (dx * dx + dy * dy <= radiusSq) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void SceneInstanceTable::QueryDrawDistance(float centerX, float centerY, float maxRadius, std::vector<uint32_t>& indices) const {
+    indices.clear();
+
+    // Квадраты радиусов считаются один раз на модель, а не на экземпляр
+    const float maxRadiusSq = maxRadius * maxRadius;
+    m_radiusSqScratch.resize(m_models.size());
+    for (size_t i = 0; i < m_models.size(); i++) {
+        float drawDistance = m_models[i].drawDistance;
+        m_radiusSqScratch[i] = (drawDistance > 0.0f && drawDistance < maxRadius) ? drawDistance * drawDistance : maxRadiusSq;
+    }
+
+    const float* xs = m_x.data();
+    const float* ys = m_y.data();
+    const uint32_t* handles = m_modelHandles.data();
+    const float* radiusSq = m_radiusSqScratch.data();
+    const size_t count = m_x.size();
+    for (size_t i = 0; i < count; i++) {
+        float dx = xs[i] - centerX;
+        float dy = ys[i] - centerY;
+        if (dx * dx + dy * dy <= radiusSq[handles[i]]) {
+            indices.push_back(static_cast<uint32_t>(i));
+        }
+    }
+}
+
+void SceneInstanceTable::Reserve(size_t count) {
+    m_x.reserve(count);
+    m_y.reserve(count);
+    m_z.reserve(count);
+    m_rotations.reserve(count);
+    m_modelHandles.reserve(count);
+    m_interiors.reserve(count);
+    m_lods.reserve(count);
+}
+
+void SceneInstanceTable::Clear() {
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_rotations.clear();
+    m_modelHandles.clear();
+    m_interiors.clear();
+    m_lods.clear();
+    m_models.clear();
+    m_modelIndex.clear();
+    m_radiusSqScratch.clear();
+}
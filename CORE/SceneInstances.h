@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <cstdint>
+
+#include "Loader.h"
+
+// Таблица экземпляров сцены в виде структуры массивов (SoA).
+// Каждое поле экземпляра лежит в своем массиве: отсечение по радиусу читает только X и Y,
+// рендер и экспорт - только нужные им колонки. Имя модели хранится один раз в таблице моделей,
+// экземпляр ссылается на него 32-битным дескриптором.
+class SceneInstanceTable {
+public:
+    // Поворот экземпляра
+    struct Quaternion {
+        float x, y, z, w;
+    };
+
+    // Запись таблицы моделей (одна на уникальное имя)
+    struct ModelRecord {
+        std::string name;
+        int modelId;            // ID из IPL (-1 - неизвестен)
+        float drawDistance;     // Дальность прорисовки из IDE (0 - неизвестна, действует общий радиус)
+    };
+
+    static const uint32_t kInvalidModel = 0xFFFFFFFFu;
+
+    // Получить дескриптор модели по имени (новое имя добавляется в таблицу моделей)
+    uint32_t InternModel(std::string_view name, int modelId = -1);
+
+    // Найти дескриптор модели по имени (kInvalidModel - имени нет)
+    uint32_t FindModel(std::string_view name) const;
+
+    // Задать дальность прорисовки модели (0 - использовать общий радиус)
+    void SetModelDrawDistance(uint32_t handle, float drawDistance) { m_models[handle].drawDistance = drawDistance; }
+
+    // Добавить экземпляр, вернуть его индекс
+    size_t AddInstance(uint32_t model, float x, float y, float z, const Quaternion& rotation, int interior = 0, int lod = -1);
+    size_t AddIplObject(const ipl::IplObject& object);
+    void AddIplObjects(const std::vector<ipl::IplObject>& objects);
+
+    // Собрать экземпляр обратно в IplObject (для инструментов, работающих со списком объектов)
+    ipl::IplObject GetIplObject(size_t index) const;
+
+    // Отсечение по радиусу в плоскости XY: индексы экземпляров в радиусе (читаются только колонки X и Y)
+    void QueryRadius(float centerX, float centerY, float radius, std::vector<uint32_t>& indices) const;
+
+    // То же, но у каждой модели свой радиус: ее дальность прорисовки, не больше maxRadius
+    // (модели без дальности используют maxRadius)
+    void QueryDrawDistance(float centerX, float centerY, float maxRadius, std::vector<uint32_t>& indices) const;
+
+    void Reserve(size_t count);
+    void Clear();
+
+    // Размеры
+    size_t Size() const { return m_x.size(); }
+    size_t GetModelCount() const { return m_models.size(); }
+
+    // Колонки
+    const std::vector<float>& GetX() const { return m_x; }
+    const std::vector<float>& GetY() const { return m_y; }
+    const std::vector<float>& GetZ() const { return m_z; }
+    const std::vector<Quaternion>& GetRotations() const { return m_rotations; }
+    const std::vector<uint32_t>& GetModelHandles() const { return m_modelHandles; }
+    const std::vector<int32_t>& GetInteriors() const { return m_interiors; }
+    const std::vector<int32_t>& GetLods() const { return m_lods; }
+
+    // Таблица моделей
+    const ModelRecord& GetModel(uint32_t handle) const { return m_models[handle]; }
+    const std::string& GetModelName(size_t instanceIndex) const { return m_models[m_modelHandles[instanceIndex]].name; }
+    int GetModelId(size_t instanceIndex) const { return m_models[m_modelHandles[instanceIndex]].modelId; }
+
+private:
+    // Колонки экземпляров
+    std::vector<float> m_x, m_y, m_z;
+    std::vector<Quaternion> m_rotations;
+    std::vector<uint32_t> m_modelHandles;
+    std::vector<int32_t> m_interiors;
+    std::vector<int32_t> m_lods;
+
+    // Таблица моделей и поиск по имени
+    std::vector<ModelRecord> m_models;
+    std::map<std::string, uint32_t, std::less<>> m_modelIndex;
+
+    // Квадраты радиусов моделей для QueryDrawDistance (буфер переиспользуется между вызовами)
+    mutable std::vector<float> m_radiusSqScratch;
+};
@@ -0,0 +1,346 @@
+#include "SceneManifest.h"
+#include "Logger.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <type_traits>
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+// Заголовок файла манифеста
+struct ManifestHeader {
+    char magic[4];                  // "SCNM"
+    uint32_t version;
+    uint32_t inputCount;
+    uint32_t definitionCount;
+    uint32_t placementCount;
+};
+
+// Запись в буфер: числа и структуры побайтно, строки - длина + байты
+class ManifestWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "В манифест пишутся только простые типы");
+        const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+        m_buffer.insert(m_buffer.end(), bytes, bytes + sizeof(T));
+    }
+
+    void WriteString(const std::string& value) {
+        Write(static_cast<uint32_t>(value.size()));
+        m_buffer.insert(m_buffer.end(), value.begin(), value.end());
+    }
+
+    const std::vector<uint8_t>& GetBuffer() const { return m_buffer; }
+
+private:
+    std::vector<uint8_t> m_buffer;
+};
+
+// Чтение из отображенного файла с проверкой границ: после первой ошибки все чтения неуспешны
+class ManifestReader {
+public:
+    ManifestReader(const uint8_t* data, size_t size) : m_cursor(data), m_end(data + size), m_ok(true) {}
+
+    template <typename T>
+    bool Read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Из манифеста читаются только простые типы");
+        if (!m_ok || static_cast<size_t>(m_end - m_cursor) < sizeof(T)) {
+            m_ok = false;
+            return false;
+        }
+        memcpy(&value, m_cursor, sizeof(T));
+        m_cursor += sizeof(T);
+        return true;
+    }
+
+    bool ReadString(std::string& value) {
+        uint32_t length = 0;
+        if (!Read(length) || static_cast<size_t>(m_end - m_cursor) < length) {
+            m_ok = false;
+            return false;
+        }
+        value.assign(reinterpret_cast<const char*>(m_cursor), length);
+        m_cursor += length;
+        return true;
+    }
+
+    bool IsOk() const { return m_ok; }
+    void Fail() { m_ok = false; }
+    bool IsAtEnd() const { return m_cursor == m_end; }
+
+    // Хватит ли оставшихся байт на count записей: счетчики из заголовка проверяются до выделения памяти
+    bool CanHold(uint32_t count, size_t minRecordSize) const {
+        return count <= static_cast<size_t>(m_end - m_cursor) / minRecordSize;
+    }
+
+private:
+    const uint8_t* m_cursor;
+    const uint8_t* m_end;
+    bool m_ok;
+};
+
+// Минимальные размеры записей на диске (все строки пустые)
+static constexpr size_t kMinInputSize = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint64_t) * 2;
+static constexpr size_t kMinDefinitionSize = sizeof(int32_t) * 3 + sizeof(float) + sizeof(uint32_t) + sizeof(uint8_t) +
+                                             sizeof(uint32_t) * 3;
+static constexpr size_t kMinPlacementSize = sizeof(uint32_t) * 2 + sizeof(int32_t) * 3 + sizeof(float) * 8;
+
+static void writeInput(ManifestWriter& writer, const SceneManifest::InputFile& input) {
+    writer.WriteString(input.path);
+    writer.Write(static_cast<uint8_t>(input.exists ? 1 : 0));
+    writer.Write(input.size);
+    writer.Write(input.modifiedTime);
+}
+
+static bool readInput(ManifestReader& reader, SceneManifest::InputFile& input) {
+    uint8_t exists = 0;
+    reader.ReadString(input.path);
+    reader.Read(exists);
+    reader.Read(input.size);
+    reader.Read(input.modifiedTime);
+    input.exists = exists != 0;
+    return reader.IsOk();
+}
+
+static void writeDefinition(ManifestWriter& writer, const ide::ObjectDefinition& definition) {
+    writer.Write(static_cast<int32_t>(definition.modelId));
+    writer.Write(definition.drawDistance);
+    writer.Write(definition.flags);
+    writer.Write(static_cast<int32_t>(definition.timeOn));
+    writer.Write(static_cast<int32_t>(definition.timeOff));
+    writer.Write(static_cast<uint8_t>(definition.section));
+    writer.WriteString(definition.modelName);
+    writer.WriteString(definition.txdName);
+    writer.WriteString(definition.animName);
+}
+
+static bool readDefinition(ManifestReader& reader, ide::ObjectDefinition& definition) {
+    int32_t modelId = 0, timeOn = 0, timeOff = 0;
+    uint8_t section = 0;
+    reader.Read(modelId);
+    reader.Read(definition.drawDistance);
+    reader.Read(definition.flags);
+    reader.Read(timeOn);
+    reader.Read(timeOff);
+    reader.Read(section);
+    reader.ReadString(definition.modelName);
+    reader.ReadString(definition.txdName);
+    reader.ReadString(definition.animName);
+    definition.modelId = modelId;
+    definition.timeOn = timeOn;
+    definition.timeOff = timeOff;
+    definition.section = static_cast<ide::Section>(section);
+    return reader.IsOk() && section <= static_cast<uint8_t>(ide::Section::Anim);
+}
+
+static void writePlacement(ManifestWriter& writer, const SceneManifest::ResolvedPlacement& resolved) {
+    const ModelStreamer::Placement& placement = resolved.placement;
+    writer.WriteString(resolved.modelName);
+    writer.WriteString(placement.objectName);
+    writer.Write(static_cast<int32_t>(placement.modelId));
+    writer.Write(static_cast<int32_t>(placement.groupIndex));
+    writer.Write(static_cast<int32_t>(placement.lodGroupIndex));
+    const float values[] = { placement.x, placement.y, placement.z,
+                             placement.rx, placement.ry, placement.rz, placement.rw, placement.drawDistance };
+    writer.Write(values);
+}
+
+static bool readPlacement(ManifestReader& reader, SceneManifest::ResolvedPlacement& resolved) {
+    ModelStreamer::Placement& placement = resolved.placement;
+    int32_t modelId = 0, groupIndex = 0, lodGroupIndex = 0;
+    float values[8] = {};
+    reader.ReadString(resolved.modelName);
+    reader.ReadString(placement.objectName);
+    reader.Read(modelId);
+    reader.Read(groupIndex);
+    reader.Read(lodGroupIndex);
+    reader.Read(values);
+    placement.modelId = modelId;
+    placement.groupIndex = groupIndex;
+    placement.lodGroupIndex = lodGroupIndex;
+    placement.x = values[0];
+    placement.y = values[1];
+    placement.z = values[2];
+    placement.rx = values[3];
+    placement.ry = values[4];
+    placement.rz = values[5];
+    placement.rw = values[6];
+    placement.drawDistance = values[7];
+    return reader.IsOk();
+}
+
+SceneManifest::InputFile SceneManifest::DescribeInput(const std::string& path) {
+    InputFile input{ path, false, 0, 0 };
+
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(path, error);
+    if (error) {
+        return input;
+    }
+    auto modified = std::filesystem::last_write_time(path, error);
+    if (error) {
+        return input;
+    }
+
+    input.exists = true;
+    input.size = size;
+    input.modifiedTime = static_cast<int64_t>(modified.time_since_epoch().count());
+    return input;
+}
+
+bool SceneManifest::Load(const std::string& path, const std::vector<InputFile>& expectedInputs) {
+#ifdef _WIN32
+    // Манифест отображается в память и разбирается прямо из отображения
+    HANDLE hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(hFile, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(ManifestHeader))) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping) {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    void* view = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!view) {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    const uint8_t* data = static_cast<const uint8_t*>(view);
+    const size_t dataSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::vector<uint8_t> buffer(static_cast<size_t>(file.tellg()));
+    file.seekg(0, std::ios::beg);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    const uint8_t* data = buffer.data();
+    const size_t dataSize = buffer.size();
+#endif
+
+    bool loaded = false;
+    ManifestReader reader(data, dataSize);
+    ManifestHeader header;
+    if (reader.Read(header) && memcmp(header.magic, "SCNM", 4) == 0 && header.version == kVersion &&
+        header.inputCount == expectedInputs.size() && reader.CanHold(header.inputCount, kMinInputSize)) {
+        // Сначала ключ: любой измененный, добавленный или удаленный входной файл делает манифест устаревшим
+        bool inputsMatch = true;
+        std::vector<InputFile> storedInputs(header.inputCount);
+        for (size_t i = 0; i < storedInputs.size() && inputsMatch; i++) {
+            inputsMatch = readInput(reader, storedInputs[i]) && storedInputs[i] == expectedInputs[i];
+        }
+
+        if (inputsMatch && !reader.CanHold(header.definitionCount, kMinDefinitionSize)) {
+            LogWarning("Манифест сцены поврежден: " + path);
+        }
+        else if (inputsMatch) {
+            std::vector<ide::ObjectDefinition> storedDefinitions(header.definitionCount);
+            for (auto& definition : storedDefinitions) {
+                if (!readDefinition(reader, definition)) break;
+            }
+
+            std::vector<ResolvedPlacement> storedPlacements;
+            if (reader.IsOk() && reader.CanHold(header.placementCount, kMinPlacementSize)) {
+                storedPlacements.resize(header.placementCount);
+                for (auto& placement : storedPlacements) {
+                    if (!readPlacement(reader, placement)) break;
+                }
+            }
+            else {
+                reader.Fail();
+            }
+
+            SceneStats storedStats;
+            reader.Read(storedStats);
+
+            if (reader.IsOk() && reader.IsAtEnd()) {
+                inputs = std::move(storedInputs);
+                definitions = std::move(storedDefinitions);
+                placements = std::move(storedPlacements);
+                stats = storedStats;
+                loaded = true;
+            }
+            else {
+                LogWarning("Манифест сцены поврежден: " + path);
+            }
+        }
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(hMapping);
+    CloseHandle(hFile);
+#endif
+    return loaded;
+}
+
+bool SceneManifest::Save(const std::string& path) const {
+    ManifestWriter writer;
+
+    ManifestHeader header;
+    memcpy(header.magic, "SCNM", 4);
+    header.version = kVersion;
+    header.inputCount = static_cast<uint32_t>(inputs.size());
+    header.definitionCount = static_cast<uint32_t>(definitions.size());
+    header.placementCount = static_cast<uint32_t>(placements.size());
+    writer.Write(header);
+
+    for (const auto& input : inputs) {
+        writeInput(writer, input);
+    }
+    for (const auto& definition : definitions) {
+        writeDefinition(writer, definition);
+    }
+    for (const auto& placement : placements) {
+        writePlacement(writer, placement);
+    }
+    writer.Write(stats);
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            LogError("Не удалось создать манифест сцены: " + tempPath);
+            return false;
+        }
+        const std::vector<uint8_t>& buffer = writer.GetBuffer();
+        file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+        if (!file) {
+            LogError("Ошибка записи манифеста сцены: " + tempPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        LogError("Не удалось заменить манифест сцены: " + path + " (" + error.message() + ")");
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+ide::IdeData SceneManifest::BuildDefinitions() const {
+    ide::IdeData result;
+    for (const auto& definition : definitions) {
+        result.addDefinition(definition);
+    }
+    return result;
+}
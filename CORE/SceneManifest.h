@@ -0,0 +1,66 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "Loader.h"
+#include "Streaming.h"
+
+// Бинарный манифест сцены: результат холодной загрузки (определения IDE, разрешенные размещения
+// моделей и статистика сцены). Ключ - размеры и время изменения всех входных файлов: если ни один
+// не изменился, следующий запуск отображает манифест в память и пропускает разбор IDE/IPL,
+// группировку объектов и выбор моделей.
+class SceneManifest {
+public:
+    // Версия формата; увеличивается при изменении раскладки или алгоритмов, результат которых хранится
+    static const uint32_t kVersion = 2;
+
+    // Входной файл и его отпечаток
+    struct InputFile {
+        std::string path;
+        bool exists;
+        uint64_t size;
+        int64_t modifiedTime;       // Время изменения (тики файловых часов)
+
+        bool operator==(const InputFile& other) const {
+            return path == other.path && exists == other.exists && size == other.size && modifiedTime == other.modifiedTime;
+        }
+    };
+
+    // Размещение группы объектов с уже выбранной моделью
+    struct ResolvedPlacement {
+        std::string modelName;                  // DFF в IMG (пусто - модель не найдена, fallback)
+        ModelStreamer::Placement placement;
+        const img::AssetIndex::Entry* modelEntry = nullptr;    // Запись индекса для modelName (в манифест не пишется)
+    };
+
+    // Итоги сборки сцены (для статистики теплого старта)
+    struct SceneStats {
+        uint64_t objectCount = 0;       // Объектов IPL после слияния
+        uint64_t modelNameCount = 0;    // Уникальных имен моделей
+        uint64_t groupCount = 0;        // Групп объектов
+        uint64_t duplicateCount = 0;    // Объектов, поглощенных группами
+        uint64_t lodLinkCount = 0;      // Групп, связанных с LOD-родителем
+        uint64_t lodObjectCount = 0;    // Объектов, служащих LOD для других
+        float minX = 0.0f, minY = 0.0f, minZ = 0.0f;   // Границы сцены
+        float maxX = 0.0f, maxY = 0.0f, maxZ = 0.0f;
+    };
+
+    // Снять отпечаток файла (отсутствующий файл тоже попадает в ключ)
+    static InputFile DescribeInput(const std::string& path);
+
+    // Загрузить манифест; false - файла нет, он поврежден, другой версии или входные файлы изменились
+    bool Load(const std::string& path, const std::vector<InputFile>& expectedInputs);
+
+    // Записать манифест (через временный файл, чтобы оборванная запись не оставила битый кэш)
+    bool Save(const std::string& path) const;
+
+    // Собрать таблицу определений IDE из манифеста
+    ide::IdeData BuildDefinitions() const;
+
+    std::vector<InputFile> inputs;
+    std::vector<ide::ObjectDefinition> definitions;
+    std::vector<ResolvedPlacement> placements;
+    SceneStats stats;
+};
@@ -0,0 +1,283 @@
+#include "Streaming.h"
+#include "AssetCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Сколько моделей рабочий поток забирает за раз: их файлы читаются одним пакетом (fetchBatch)
+static const size_t kStreamBatchSize = 8;
+
+// Минимальный сдвиг камеры, после которого пересчитывается очередь
+static const float kCameraRequeueDistance = 5.0f;
+
+ModelStreamer::ModelStreamer()
+    : m_assetIndex(nullptr), m_placementCount(0), m_loadingCount(0), m_stopping(false),
+      m_lastCameraX(0.0f), m_lastCameraY(0.0f), m_lastRadius(0.0f), m_hasCamera(false),
+      m_completedCount(0), m_failedCount(0), m_cancelledCount(0) {
+}
+
+ModelStreamer::~ModelStreamer() {
+    Stop();
+}
+
+void ModelStreamer::AddPlacement(const std::string& modelName, const img::AssetIndex::Entry& indexEntry, const Placement& placement) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_modelIndex.find(modelName);
+    if (it == m_modelIndex.end()) {
+        ModelEntry entry;
+        entry.name = modelName;
+        entry.indexEntry = &indexEntry;
+        it = m_modelIndex.emplace(modelName, m_models.size()).first;
+        m_models.push_back(std::move(entry));
+    }
+
+    m_models[it->second].placements.push_back(placement);
+    m_placementCount++;
+}
+
+void ModelStreamer::Start(const img::AssetIndex* assetIndex, size_t threadCount) {
+    Stop();
+
+    m_assetIndex = assetIndex;
+    m_stopping = false;
+
+    if (threadCount == 0) {
+        // Один аппаратный поток оставляем основному (рендер и загрузка в GPU)
+        unsigned int hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&ModelStreamer::WorkerLoop, this);
+    }
+}
+
+void ModelStreamer::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    m_workers.clear();
+}
+
+float ModelStreamer::MinDistanceSq(const ModelEntry& entry, float cameraX, float cameraY) {
+    float best = -1.0f;
+    for (const auto& placement : entry.placements) {
+        float dx = placement.x - cameraX;
+        float dy = placement.y - cameraY;
+        float distanceSq = dx * dx + dy * dy;
+        if (best < 0.0f || distanceSq < best) {
+            best = distanceSq;
+        }
+    }
+    return best;
+}
+
+bool ModelStreamer::AnyPlacementInRange(const ModelEntry& entry, float cameraX, float cameraY, float radius) {
+    for (const auto& placement : entry.placements) {
+        float range = (placement.drawDistance > 0.0f && placement.drawDistance < radius) ? placement.drawDistance : radius;
+        float dx = placement.x - cameraX;
+        float dy = placement.y - cameraY;
+        if (dx * dx + dy * dy <= range * range) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ModelStreamer::UpdateCamera(float cameraX, float cameraY, float radius) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Пересчитываем очередь только при заметном сдвиге камеры или смене радиуса
+    if (m_hasCamera && radius == m_lastRadius &&
+        std::abs(cameraX - m_lastCameraX) <= kCameraRequeueDistance &&
+        std::abs(cameraY - m_lastCameraY) <= kCameraRequeueDistance) {
+        return;
+    }
+    m_lastCameraX = cameraX;
+    m_lastCameraY = cameraY;
+    m_lastRadius = radius;
+    m_hasCamera = true;
+
+    m_queue.clear();
+
+    for (size_t i = 0; i < m_models.size(); i++) {
+        ModelEntry& entry = m_models[i];
+        if (entry.state != ModelState::Idle && entry.state != ModelState::Queued && entry.state != ModelState::Loading) {
+            continue;
+        }
+
+        entry.distanceSq = MinDistanceSq(entry, cameraX, cameraY);
+        bool inRange = AnyPlacementInRange(entry, cameraX, cameraY, radius);
+
+        if (entry.state == ModelState::Loading) {
+            // Результат загрузки отбросим, если модель так и останется вне радиуса
+            entry.cancelRequested = !inRange;
+            continue;
+        }
+
+        if (inRange) {
+            entry.state = ModelState::Queued;
+            m_queue.push_back(i);
+        } else if (entry.state == ModelState::Queued) {
+            entry.state = ModelState::Idle;
+            m_cancelledCount++;
+        }
+    }
+
+    // Ближайшие модели - в конце очереди, рабочие потоки забирают их первыми
+    std::sort(m_queue.begin(), m_queue.end(), [this](size_t a, size_t b) {
+        return m_models[a].distanceSq > m_models[b].distanceSq;
+    });
+
+    if (!m_queue.empty()) {
+        m_condition.notify_all();
+    }
+}
+
+void ModelStreamer::WorkerLoop() {
+    for (;;) {
+        // Забираем несколько ближайших моделей
+        std::vector<size_t> jobs;
+        std::vector<std::string> names;
+        std::vector<const img::AssetIndex::Entry*> indexEntries;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+            if (m_stopping) {
+                return;
+            }
+
+            while (!m_queue.empty() && jobs.size() < kStreamBatchSize) {
+                size_t modelIndex = m_queue.back();
+                m_queue.pop_back();
+
+                ModelEntry& entry = m_models[modelIndex];
+                entry.state = ModelState::Loading;
+                entry.cancelRequested = false;
+                jobs.push_back(modelIndex);
+                names.push_back(entry.name);
+                indexEntries.push_back(entry.indexEntry);
+            }
+            m_loadingCount++;
+        }
+
+        // Раскладываем файлы по архивам: каждый архив читается одним пакетом.
+        // Модели, уже разобранные раньше, берем из кэша без чтения и разбора.
+        std::map<const img::ImgData*, std::vector<size_t>> jobsByArchive;
+        std::vector<StreamedModel> results(jobs.size());
+        for (size_t i = 0; i < jobs.size(); i++) {
+            results[i].modelName = names[i];
+            results[i].assetKey = 0;
+            results[i].success = false;
+
+            const img::AssetIndex::Entry* indexEntry = indexEntries[i];
+            if (!m_assetIndex || !indexEntry) {
+                continue;
+            }
+
+            // Ключ и чтение - по первой копии содержимого: дубликаты разбираются один раз
+            img::AssetIndex::ContentRef content = m_assetIndex->getContent(*indexEntry);
+            results[i].assetKey = AssetCache::MakeKey(content.archive, content.entry);
+            auto cached = AssetCache::Models().Find(results[i].assetKey);
+            if (cached) {
+                results[i].model = cached;
+                results[i].success = true;
+                continue;
+            }
+            jobsByArchive[m_assetIndex->getContentArchive(*indexEntry)].push_back(i);
+        }
+
+        for (const auto& archiveJobs : jobsByArchive) {
+            const img::ImgData* archive = archiveJobs.first;
+
+            // В пакет идут имена в регистре каталога архива
+            std::vector<std::string> entryNames;
+            for (size_t i : archiveJobs.second) {
+                img::AssetIndex::ContentRef content = m_assetIndex->getContent(*indexEntries[i]);
+                const char* entryName = archive->getEntryName(content.entry);
+                entryNames.push_back(std::string(entryName, strnlen(entryName, 24)));
+            }
+
+            img::ImgBatch batch;
+            archive->fetchBatch(entryNames, batch);
+
+            for (size_t j = 0; j < archiveJobs.second.size(); j++) {
+                StreamedModel& result = results[archiveJobs.second[j]];
+                if (batch.views[j].data.empty()) {
+                    continue;
+                }
+
+                dff::DffData dffData;
+                if (dffData.loadDffFromBuffer(batch.views[j].data, result.modelName)) {
+                    auto model = std::make_shared<const dff::DffModel>(dffData.getModel());
+                    AssetCache::Models().Insert(result.assetKey, model, AssetCache::EstimateBytes(*model));
+                    result.model = model;
+                    result.success = true;
+                }
+            }
+        }
+
+        // Публикуем результаты
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < jobs.size(); i++) {
+                ModelEntry& entry = m_models[jobs[i]];
+
+                if (entry.cancelRequested) {
+                    // Камера ушла, пока модель грузилась - вернем в очередь при следующем приближении
+                    entry.state = ModelState::Idle;
+                    entry.cancelRequested = false;
+                    m_cancelledCount++;
+                    continue;
+                }
+
+                if (results[i].success) {
+                    entry.state = ModelState::Finished;
+                    m_completedCount++;
+                } else {
+                    entry.state = ModelState::Failed;
+                    m_failedCount++;
+                }
+                results[i].placements = entry.placements;
+                m_finished.push_back(std::move(results[i]));
+            }
+            m_loadingCount--;
+        }
+    }
+}
+
+void ModelStreamer::CollectFinished(std::vector<StreamedModel>& finished, size_t maxCount) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t count = std::min(maxCount, m_finished.size());
+    for (size_t i = 0; i < count; i++) {
+        StreamedModel& result = m_finished[i];
+        auto it = m_modelIndex.find(result.modelName);
+        if (it != m_modelIndex.end() && m_models[it->second].state == ModelState::Finished) {
+            m_models[it->second].state = ModelState::Delivered;
+        }
+        finished.push_back(std::move(result));
+    }
+    m_finished.erase(m_finished.begin(), m_finished.begin() + count);
+}
+
+size_t ModelStreamer::GetQueuedCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.size();
+}
+
+bool ModelStreamer::IsIdle() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_queue.empty() && m_loadingCount == 0 && m_finished.empty();
+}
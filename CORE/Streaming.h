@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+#include "Loader.h"
+
+// Фоновый стриминг DFF моделей из IMG архивов.
+// Модели регистрируются один раз (модель -> список размещений в мире), рабочие потоки
+// читают и разбирают ближайшие к камере модели, готовые результаты забирает основной поток
+// и передает в Renderer (загрузка в GPU остается в основном потоке с контекстом OpenGL).
+class ModelStreamer {
+public:
+    // Размещение модели в мире (одна группа объектов IPL)
+    struct Placement {
+        std::string objectName;     // Имя объекта из IPL (для fallback из unpack)
+        int modelId;
+        int groupIndex;             // Номер группы объектов (для fallback куба и ключ в иерархии LOD)
+        float x, y, z;
+        float rx, ry, rz, rw;
+        float drawDistance;         // Дальность прорисовки из IDE (0 - общий радиус)
+        int lodGroupIndex;          // groupIndex размещения LOD-родителя (-1 - нет)
+    };
+
+    // Результат работы потока: разобранная модель (общая с кэшем ассетов) и все ее размещения
+    struct StreamedModel {
+        std::string modelName;
+        uint64_t assetKey;          // Ключ модели в кэше ассетов (для реестра моделей Renderer)
+        bool success;
+        std::shared_ptr<const dff::DffModel> model;
+        std::vector<Placement> placements;
+    };
+
+    ModelStreamer();
+    ~ModelStreamer();
+
+    // Зарегистрировать размещение модели (до Start, из основного потока).
+    // indexEntry - запись индекса, найденная при сборке сцены: рабочие потоки имя больше не ищут
+    void AddPlacement(const std::string& modelName, const img::AssetIndex::Entry& indexEntry, const Placement& placement);
+
+    // Запустить рабочие потоки (threadCount == 0 - по числу ядер, минус основной поток)
+    void Start(const img::AssetIndex* assetIndex, size_t threadCount = 0);
+
+    // Остановить потоки; незавершенные запросы отбрасываются
+    void Stop();
+
+    // Пересчитать приоритеты по позиции камеры (основной поток, каждый кадр).
+    // Модели в радиусе ставятся в очередь от ближних к дальним, вышедшие из радиуса - снимаются.
+    // Размещение с дальностью прорисовки меньше радиуса нужно только в пределах своей дальности.
+    void UpdateCamera(float cameraX, float cameraY, float radius);
+
+    // Забрать готовые модели (не больше maxCount за вызов, чтобы не проседал кадр)
+    void CollectFinished(std::vector<StreamedModel>& finished, size_t maxCount);
+
+    // Статистика
+    size_t GetModelCount() const { return m_models.size(); }
+    size_t GetPlacementCount() const { return m_placementCount; }
+    size_t GetQueuedCount() const;
+    size_t GetCompletedCount() const { return m_completedCount.load(); }
+    size_t GetFailedCount() const { return m_failedCount.load(); }
+    size_t GetCancelledCount() const { return m_cancelledCount.load(); }
+    bool IsIdle() const;
+
+private:
+    // Состояние модели в стримере
+    enum class ModelState {
+        Idle,       // Не нужна (вне радиуса) или снята с очереди
+        Queued,     // Ждет рабочего потока
+        Loading,    // Читается и разбирается
+        Finished,   // Лежит в списке готовых
+        Delivered,  // Передана в Renderer
+        Failed      // Файл не найден или не разобрался
+    };
+
+    struct ModelEntry {
+        std::string name;
+        const img::AssetIndex::Entry* indexEntry = nullptr;
+        std::vector<Placement> placements;
+        ModelState state = ModelState::Idle;
+        float distanceSq = 0.0f;        // Квадрат расстояния ближайшего размещения до камеры
+        bool cancelRequested = false;   // Вышла из радиуса во время загрузки
+    };
+
+    void WorkerLoop();
+
+    // Минимальный квадрат расстояния от камеры до размещений модели (по X и Y, как в Renderer)
+    static float MinDistanceSq(const ModelEntry& entry, float cameraX, float cameraY);
+
+    // Есть ли размещение в пределах своей дальности прорисовки (не дальше radius)
+    static bool AnyPlacementInRange(const ModelEntry& entry, float cameraX, float cameraY, float radius);
+
+    const img::AssetIndex* m_assetIndex;
+    std::vector<ModelEntry> m_models;
+    std::map<std::string, size_t> m_modelIndex;   // Имя модели -> индекс в m_models
+    size_t m_placementCount;
+
+    // Очередь: индексы моделей, отсортированные от дальних к ближним (ближняя - в конце)
+    std::vector<size_t> m_queue;
+    std::vector<StreamedModel> m_finished;
+    size_t m_loadingCount;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_condition;
+    std::vector<std::thread> m_workers;
+    bool m_stopping;
+
+    // Последняя позиция камеры, по которой пересчитывалась очередь
+    float m_lastCameraX, m_lastCameraY, m_lastRadius;
+    bool m_hasCamera;
+
+    std::atomic<size_t> m_completedCount;
+    std::atomic<size_t> m_failedCount;
+    std::atomic<size_t> m_cancelledCount;
+};
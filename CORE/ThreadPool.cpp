@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount) : m_stopping(false) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    m_workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; i++) {
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+}
+
+void ThreadPool::Enqueue(std::function<void()> job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push(std::move(job));
+    }
+    m_condition.notify_one();
+}
+
+void ThreadPool::WorkerLoop() {
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [this]() { return m_stopping || !m_jobs.empty(); });
+
+            // Перед выходом дорабатываем уже поставленные задачи
+            if (m_stopping && m_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(m_jobs.front());
+            m_jobs.pop();
+        }
+        job();
+    }
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // Итерации раздаются через общий счетчик: тяжелые элементы не блокируют остальные
+    auto next = std::make_shared<std::atomic<size_t>>(0);
+    size_t taskCount = std::min(count, m_workers.size());
+
+    std::vector<std::future<void>> futures;
+    futures.reserve(taskCount);
+    for (size_t t = 0; t < taskCount; t++) {
+        futures.push_back(Submit([next, count, &body]() {
+            for (size_t i = next->fetch_add(1); i < count; i = next->fetch_add(1)) {
+                body(i);
+            }
+        }));
+    }
+
+    // Дожидаемся всех задач (они ссылаются на body), затем пробрасываем первое исключение
+    std::exception_ptr firstError;
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+        }
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+// Пул рабочих потоков для фоновых задач загрузки (IMG, IPL, DFF)
+class ThreadPool {
+public:
+    // threadCount == 0 - по числу аппаратных потоков
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Поставить задачу в очередь, результат - через future
+    template <typename F>
+    auto Submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        Enqueue([packaged]() { (*packaged)(); });
+        return future;
+    }
+
+    // Выполнить body(i) для i в [0, count) и дождаться завершения всех итераций.
+    // Нельзя вызывать из задачи этого же пула - рабочие потоки заблокируются в ожидании.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+    // Количество рабочих потоков
+    size_t GetThreadCount() const { return m_workers.size(); }
+
+private:
+    void Enqueue(std::function<void()> job);
+    void WorkerLoop();
+
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_jobs;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping;
+};
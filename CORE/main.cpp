@@ -7,6 +7,11 @@
 #include <algorithm>
 #include <thread>
 #include <chrono>
+#include <cstring>
+#include <cmath>
+#include <bit>
+#include <random>
+#include <unordered_map>
 #include <windows.h>
 
 // Включаем наши заголовочные файлы
@@ -16,6 +21,11 @@
 #include "Input.h"
 #include "Logger.h"
 #include "CollisionGtaSaParser.h"
+#include "ThreadPool.h"
+#include "Streaming.h"
+#include "AssetCache.h"
+#include "SceneInstances.h"
+#include "SceneManifest.h"
 
 // Константы для настройки
 const int MAX_IPL_OBJECTS_TO_CREATE = 1000000;  // Максимальное количество тестовых кубов
@@ -46,13 +56,14 @@ bool extractColFilesFromImg(const img::ImgData& imgData, const std::string& outp
         return false;
     }
     
-    // Получаем все файлы с расширением .col
-    auto colFiles = imgData.getFilesByExtension(".col");
+    // Получаем представления всех файлов с расширением .col (без копирования данных)
+    auto colFiles = imgData.getFileViewsByExtension(".col");
     LogCol("Найдено .col файлов: " + std::to_string(colFiles.size()));
     
     int extractedCount = 0;
     for (const auto& colFile : colFiles) {
-        std::string outputPath = outputDir + "\\" + colFile.name;
+        std::string colName(colFile.name);
+        std::string outputPath = outputDir + "\\" + colName;
         
         try {
             std::ofstream outFile(outputPath, std::ios::binary);
@@ -60,12 +71,12 @@ bool extractColFilesFromImg(const img::ImgData& imgData, const std::string& outp
                 outFile.write(reinterpret_cast<const char*>(colFile.data.data()), colFile.data.size());
                 outFile.close();
                 extractedCount++;
-                LogSuccess("Извлечен: " + colFile.name + " (" + std::to_string(colFile.data.size()) + " байт)");
+                LogSuccess("Извлечен: " + colName + " (" + std::to_string(colFile.data.size()) + " байт)");
             } else {
                 LogError("Не удалось создать файл: " + outputPath);
             }
         } catch (const std::exception& e) {
-            LogError("Ошибка при извлечении " + colFile.name + ": " + e.what());
+            LogError("Ошибка при извлечении " + colName + ": " + e.what());
         }
     }
     
@@ -85,13 +96,13 @@ void extractAllColFiles(const std::vector<img::ImgData>& imgDataVector, const st
     int totalExtracted = 0;
     
     for (const auto& imgData : imgDataVector) {
-        // Подсчитываем общее количество .col файлов
-        auto colFiles = imgData.getFilesByExtension(".col");
-        totalColFiles += colFiles.size();
+        // Подсчитываем общее количество .col файлов (по каталогу, без чтения данных)
+        size_t colFileCount = imgData.getFileCountByExtension(".col");
+        totalColFiles += colFileCount;
         
         // Извлекаем .col файлы из текущего IMG
         if (extractColFilesFromImg(imgData, outputDir)) {
-            totalExtracted += colFiles.size();
+            totalExtracted += colFileCount;
         }
     }
     
@@ -104,71 +115,85 @@ void extractAllColFiles(const std::vector<img::ImgData>& imgDataVector, const st
     LogCol("========================================");
 }
 
-// Функция для поиска лучшей версии модели с приоритетом LOD
-std::string findBestModelVersion(const std::vector<img::ImgData*>& imgArchives, const std::string& baseName) {
-    std::string bestModelName = baseName + ".dff";
-    
-    // В GTA SA LOD объекты имеют приписку "lod" в НАЧАЛЕ названия
-    // Например: u_land_001 -> lodand_001
-    
-    // Сначала ищем LOD версию (приписка "lod" в начале)
-    std::string lodName = "lod" + baseName + ".dff";
-    
-    // Проверяем lod{baseName}.dff
-    if (img::modelExists(imgArchives, lodName)) {
-        LogModels("Найдена LOD версия модели: " + lodName + " для " + baseName);
-        return lodName;
-    }
-    
-    // Если LOD версии нет, возвращаем обычную версию
-    if (img::modelExists(imgArchives, bestModelName)) {
-        return bestModelName;
-    }
-    
-    return ""; // Модель не найдена
-}
-
-// Функция для проверки существования модели в папке unpack с приоритетом LOD
-std::string findBestModelInUnpack(const std::string& baseName) {
-    std::string basePath = "unpack\\" + baseName + ".dff";
-    std::string lodPath = "unpack\\lod" + baseName + ".dff";
-    
-    // В GTA SA LOD объекты имеют приписку "lod" в НАЧАЛЕ названия
-    // Проверяем lod{baseName}.dff
-    if (std::filesystem::exists(lodPath)) {
-        LogModels("Найдена LOD версия модели в unpack: lod" + baseName + ".dff");
-        return lodPath;
-    }
-    
-    // Если LOD версии нет, возвращаем обычную версию
-    if (std::filesystem::exists(basePath)) {
-        return basePath;
+// Разобрать коллизии .col файлов IMG архива прямо из представлений (без извлечения на диск)
+// через кэш коллизий. Записи, затененные более приоритетным архивом, и копии уже разобранного
+// содержимого пропускаются. Возвращает количество разобранных моделей
+size_t loadColModelsFromImg(const img::AssetIndex& assetIndex, const img::ImgData& imgData, uint32_t archiveIndex,
+                            std::vector<std::shared_ptr<const std::vector<CollisionModel>>>& collisionSets) {
+    size_t modelCount = 0;
+    for (size_t entryIndex = 0; entryIndex < imgData.getEntryCount(); entryIndex++) {
+        const char* entryName = imgData.getEntryName(entryIndex);
+        std::string name(entryName, strnlen(entryName, 24));
+        std::string extension = std::filesystem::path(name).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension != ".col") {
+            continue;
+        }
+        
+        const img::AssetIndex::Entry* indexEntry = assetIndex.find(name);
+        if (!indexEntry || indexEntry->archive != archiveIndex || indexEntry->entry != entryIndex) {
+            continue;
+        }
+        img::AssetIndex::ContentRef content = assetIndex.getContent(*indexEntry);
+        if (content.archive != archiveIndex || content.entry != entryIndex) {
+            continue;
+        }
+        
+        auto models = AssetCache::LoadCol(content.archive, content.entry, imgData.getFileViewByIndex(entryIndex));
+        if (models) {
+            modelCount += models->size();
+            collisionSets.push_back(std::move(models));
+        }
+        else {
+            LogCol("Не удалось разобрать коллизии: " + name);
+        }
     }
-    
-    return ""; // Модель не найдена
+    return modelCount;
 }
 
 // Структура для группировки объектов по координатам
 struct ObjectGroup {
     float x, y, z;
     std::vector<size_t> objectIndices; // Индексы объектов в этой группе
-    std::string bestModelName;         // Лучшая модель для этой группы
-    bool hasLodVersion;                // Есть ли LOD версия
+    uint32_t bestModel;                // Дескриптор выбранной модели (kInvalidModel - нет в IMG)
+    bool isLod;                        // Группа LOD объектов (на них ссылаются поля lod других объектов)
+    int lodGroup;                      // Группа LOD-родителя (-1 - нет)
 };
 
-// Функция для группировки объектов по координатам
-std::vector<ObjectGroup> groupObjectsByCoordinates(const std::vector<ipl::IplObject>& objects, float threshold = 1.0f) {
+// Пометить объекты, которые служат LOD для других (поле lod - глобальный индекс после слияния IPL)
+std::vector<uint8_t> markLodInstances(const SceneInstanceTable& objects) {
+    std::vector<uint8_t> isLod(objects.Size(), 0);
+    for (int32_t lod : objects.GetLods()) {
+        if (lod >= 0 && static_cast<size_t>(lod) < isLod.size()) {
+            isLod[lod] = 1;
+        }
+    }
+    return isLod;
+}
+
+// Прежняя группировка по координатам: каждый объект сравнивается со всеми группами (O(n^2)).
+// Оставлена как эталон для --bench-grouping.
+// HD объект и его LOD обычно стоят в одной точке, но это разные уровни - в одну группу они не попадают
+std::vector<ObjectGroup> groupObjectsByCoordinatesLegacy(const SceneInstanceTable& objects, const std::vector<uint8_t>& isLodInstance,
+                                                         float threshold = 1.0f) {
     std::vector<ObjectGroup> groups;
+    const std::vector<float>& objectX = objects.GetX();
+    const std::vector<float>& objectY = objects.GetY();
+    const std::vector<float>& objectZ = objects.GetZ();
     
-    for (size_t i = 0; i < objects.size(); i++) {
-        const auto& obj = objects[i];
+    for (size_t i = 0; i < objects.Size(); i++) {
         bool addedToGroup = false;
+        const bool objectIsLod = isLodInstance[i] != 0;
         
-        // Ищем существующую группу для этих координат
+        // Ищем существующую группу того же уровня для этих координат
         for (auto& group : groups) {
-            float dx = abs(group.x - obj.x);
-            float dy = abs(group.y - obj.y);
-            float dz = abs(group.z - obj.z);
+            if (group.isLod != objectIsLod) {
+                continue;
+            }
+            
+            float dx = std::abs(group.x - objectX[i]);
+            float dy = std::abs(group.y - objectY[i]);
+            float dz = std::abs(group.z - objectZ[i]);
             
             if (dx <= threshold && dy <= threshold && dz <= threshold) {
                 // Добавляем объект в существующую группу
@@ -181,11 +206,13 @@ std::vector<ObjectGroup> groupObjectsByCoordinates(const std::vector<ipl::IplObj
         // Если группа не найдена, создаем новую
         if (!addedToGroup) {
             ObjectGroup newGroup;
-            newGroup.x = obj.x;
-            newGroup.y = obj.y;
-            newGroup.z = obj.z;
+            newGroup.x = objectX[i];
+            newGroup.y = objectY[i];
+            newGroup.z = objectZ[i];
             newGroup.objectIndices.push_back(i);
-            newGroup.hasLodVersion = false;
+            newGroup.isLod = objectIsLod;
+            newGroup.lodGroup = -1;
+            newGroup.bestModel = SceneInstanceTable::kInvalidModel;
             groups.push_back(newGroup);
         }
     }
@@ -193,35 +220,1058 @@ std::vector<ObjectGroup> groupObjectsByCoordinates(const std::vector<ipl::IplObj
     return groups;
 }
 
-// Функция для выбора лучшей модели для группы объектов
-std::string selectBestModelForGroup(const std::vector<img::ImgData*>& imgArchives, 
-                                   const std::vector<ipl::IplObject>& objects,
-                                   const ObjectGroup& group) {
-    std::string bestModelName = "";
-    bool hasLod = false;
+// Ячейка пространственного хэша по одной оси (NaN и огромные координаты - в ячейку 0:
+// точная проверка расстояния их все равно отбросит)
+static int32_t coordinateCell(float value, float inverseCellSize) {
+    float cell = std::floor(value * inverseCellSize);
+    return (cell > -1.0e9f && cell < 1.0e9f) ? static_cast<int32_t>(cell) : 0;
+}
+
+// Ключ ячейки: по 21 биту на ось и бит уровня (HD/LOD). Совпадение ключей у далеких ячеек
+// дает лишних кандидатов, но не ошибку - каждый кандидат проверяется точно
+static uint64_t groupCellKey(int32_t cellX, int32_t cellY, int32_t cellZ, bool isLod) {
+    const uint64_t mask = (1ull << 21) - 1;
+    return (static_cast<uint64_t>(cellX) & mask) | ((static_cast<uint64_t>(cellY) & mask) << 21) |
+           ((static_cast<uint64_t>(cellZ) & mask) << 42) | (static_cast<uint64_t>(isLod) << 63);
+}
+
+// Группировка объектов по координатам через пространственный хэш с ячейками размера threshold.
+// Результат совпадает с groupObjectsByCoordinatesLegacy: объект попадает в группу того же уровня
+// с наименьшим номером, чья точка отстоит не дальше threshold по каждой оси. Такие группы лежат
+// только в 27 соседних ячейках, поэтому проверяются только они.
+// Ячейки объектов считаются параллельно по блокам; сам проход остается последовательным,
+// так как группа объекта зависит от групп, созданных до него
+std::vector<ObjectGroup> groupObjectsByCoordinates(const SceneInstanceTable& objects, const std::vector<uint8_t>& isLodInstance,
+                                                   float threshold = 1.0f, ThreadPool* pool = nullptr) {
+    const size_t count = objects.Size();
+    const float* objectX = objects.GetX().data();
+    const float* objectY = objects.GetY().data();
+    const float* objectZ = objects.GetZ().data();
+
+    // При threshold <= 0 совпадают только равные координаты - они всегда в одной ячейке
+    const float inverseCellSize = threshold > 0.0f ? 1.0f / threshold : 1.0f;
+
+    struct Cell {
+        int32_t x, y, z;
+    };
+    std::vector<Cell> cells(count);
+    const size_t chunkSize = 8192;
+    const size_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    auto computeChunk = [&](size_t chunk) {
+        const size_t end = std::min(count, (chunk + 1) * chunkSize);
+        for (size_t i = chunk * chunkSize; i < end; i++) {
+            cells[i] = { coordinateCell(objectX[i], inverseCellSize), coordinateCell(objectY[i], inverseCellSize),
+                         coordinateCell(objectZ[i], inverseCellSize) };
+        }
+    };
+    if (pool && chunkCount > 1) {
+        pool->ParallelFor(chunkCount, computeChunk);
+    }
+    else {
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            computeChunk(chunk);
+        }
+    }
+
+    // Ячейка -> первая группа списка; следующая группа той же ячейки - в nextInCell
+    std::vector<ObjectGroup> groups;
+    std::vector<int> nextInCell;
+    std::unordered_map<uint64_t, int> cellHeads;
+    cellHeads.reserve(count);
+
+    for (size_t i = 0; i < count; i++) {
+        const bool objectIsLod = isLodInstance[i] != 0;
+        const Cell& cell = cells[i];
+
+        int bestGroup = -1;
+        for (int offsetX = -1; offsetX <= 1; offsetX++) {
+            for (int offsetY = -1; offsetY <= 1; offsetY++) {
+                for (int offsetZ = -1; offsetZ <= 1; offsetZ++) {
+                    auto head = cellHeads.find(groupCellKey(cell.x + offsetX, cell.y + offsetY, cell.z + offsetZ, objectIsLod));
+                    if (head == cellHeads.end()) {
+                        continue;
+                    }
+                    for (int groupIndex = head->second; groupIndex >= 0; groupIndex = nextInCell[groupIndex]) {
+                        const ObjectGroup& group = groups[groupIndex];
+                        if (group.isLod != objectIsLod || (bestGroup >= 0 && groupIndex >= bestGroup)) {
+                            continue;
+                        }
+
+                        float dx = std::abs(group.x - objectX[i]);
+                        float dy = std::abs(group.y - objectY[i]);
+                        float dz = std::abs(group.z - objectZ[i]);
+                        if (dx <= threshold && dy <= threshold && dz <= threshold) {
+                            bestGroup = groupIndex;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (bestGroup >= 0) {
+            groups[bestGroup].objectIndices.push_back(i);
+            continue;
+        }
+
+        // Новая группа с точкой в этом объекте
+        ObjectGroup newGroup;
+        newGroup.x = objectX[i];
+        newGroup.y = objectY[i];
+        newGroup.z = objectZ[i];
+        newGroup.objectIndices.push_back(i);
+        newGroup.isLod = objectIsLod;
+        newGroup.lodGroup = -1;
+        newGroup.bestModel = SceneInstanceTable::kInvalidModel;
+
+        const int newIndex = static_cast<int>(groups.size());
+        groups.push_back(std::move(newGroup));
+        auto [head, inserted] = cellHeads.try_emplace(groupCellKey(cell.x, cell.y, cell.z, objectIsLod), newIndex);
+        nextInCell.push_back(inserted ? -1 : head->second);
+        head->second = newIndex;
+    }
+
+    return groups;
+}
+
+// Связать группы в пары HD/LOD: родитель группы - группа, в которой лежит LOD ее объекта
+size_t linkLodGroups(const SceneInstanceTable& objects, std::vector<ObjectGroup>& groups) {
+    std::vector<int> groupOfObject(objects.Size(), -1);
+    for (size_t groupIndex = 0; groupIndex < groups.size(); groupIndex++) {
+        for (size_t objIndex : groups[groupIndex].objectIndices) {
+            groupOfObject[objIndex] = static_cast<int>(groupIndex);
+        }
+    }
     
-    // Проверяем все объекты в группе
+    const std::vector<int32_t>& lods = objects.GetLods();
+    size_t linkedCount = 0;
+    for (size_t groupIndex = 0; groupIndex < groups.size(); groupIndex++) {
+        ObjectGroup& group = groups[groupIndex];
+        for (size_t objIndex : group.objectIndices) {
+            int32_t lod = lods[objIndex];
+            if (lod < 0 || static_cast<size_t>(lod) >= groupOfObject.size()) {
+                continue;
+            }
+            int parentGroup = groupOfObject[lod];
+            if (parentGroup >= 0 && parentGroup != static_cast<int>(groupIndex)) {
+                group.lodGroup = parentGroup;
+                linkedCount++;
+                break;
+            }
+        }
+    }
+    return linkedCount;
+}
+
+// Файл модели в IMG для уникального имени модели сцены
+struct ModelResolution {
+    std::string fileName;                   // Имя DFF в IMG (пусто - модели нет в архивах)
+    const img::AssetIndex::Entry* entry;    // Запись индекса: архив и номер файла (nullptr - нет)
+};
+
+// Разрешить каждое уникальное имя модели один раз; индекс результата - дескриптор модели таблицы.
+// LOD версии - отдельные объекты IPL со своими именами, на них указывает поле lod
+std::vector<ModelResolution> resolveSceneModels(const img::AssetIndex& assetIndex, const SceneInstanceTable& objects) {
+    std::vector<ModelResolution> resolutions(objects.GetModelCount());
+    for (uint32_t handle = 0; handle < resolutions.size(); handle++) {
+        std::string fileName = objects.GetModel(handle).name + ".dff";
+        const img::AssetIndex::Entry* entry = assetIndex.find(fileName);
+        if (entry) {
+            resolutions[handle] = { std::move(fileName), entry };
+        }
+        else {
+            resolutions[handle] = { std::string(), nullptr };
+        }
+    }
+    return resolutions;
+}
+
+// Функция для выбора модели группы: первый объект группы, чья модель есть в IMG
+uint32_t selectBestModelForGroup(const std::vector<ModelResolution>& resolutions,
+                                 const SceneInstanceTable& objects,
+                                 const ObjectGroup& group) {
+    const std::vector<uint32_t>& modelHandles = objects.GetModelHandles();
     for (size_t objIndex : group.objectIndices) {
-        const auto& obj = objects[objIndex];
-        std::string modelName = findBestModelVersion(imgArchives, obj.name);
+        uint32_t handle = modelHandles[objIndex];
+        if (resolutions[handle].entry) {
+            return handle;
+        }
+    }
+    
+    return SceneInstanceTable::kInvalidModel;
+}
+
+// Сборка сцены из таблицы экземпляров: группировка по координатам, связи HD/LOD и выбор модели
+// для каждой группы. Результат не зависит от камеры - его можно сохранить в манифест сцены
+void resolveScenePlacements(const img::AssetIndex& assetIndex, const ide::IdeData& definitions, const SceneInstanceTable& sceneInstances,
+                            std::vector<SceneManifest::ResolvedPlacement>& placements, SceneManifest::SceneStats& stats, ThreadPool* pool) {
+    // Группируем объекты по координатам для предотвращения дубликатов
+    LogSystem("Группировка объектов по координатам для предотвращения дубликатов...");
+    std::vector<uint8_t> isLodInstance = markLodInstances(sceneInstances);
+    auto groupingStart = std::chrono::high_resolution_clock::now();
+    std::vector<ObjectGroup> objectGroups = groupObjectsByCoordinates(sceneInstances, isLodInstance, 1.0f, pool);
+    double groupingMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - groupingStart).count();
+    LogSystem("Создано групп объектов: " + std::to_string(objectGroups.size()) + " из " + std::to_string(sceneInstances.Size()) +
+              " объектов (" + std::to_string(groupingMs) + " мс)");
+
+    // Пары HD/LOD по полю lod объектов IPL: уровень выбирается при рендере по расстоянию
+    stats.lodLinkCount = linkLodGroups(sceneInstances, objectGroups);
+    stats.lodObjectCount = std::count(isLodInstance.begin(), isLodInstance.end(), 1);
+    LogSystem("Связано групп с LOD: " + std::to_string(stats.lodLinkCount) + " (LOD объектов: " +
+              std::to_string(stats.lodObjectCount) + ")");
+
+    // Каждое имя модели ищется в IMG один раз, дальше выбор модели группы - обращение к массиву.
+    // Лучшая модель для каждой группы выбирается заранее - так все нужные файлы известны до чтения
+    std::vector<ModelResolution> modelResolutions = resolveSceneModels(assetIndex, sceneInstances);
+    size_t resolvedModelCount = std::count_if(modelResolutions.begin(), modelResolutions.end(),
+                                              [](const ModelResolution& resolution) { return resolution.entry != nullptr; });
+    LogModels("Разрешено имен моделей в IMG: " + std::to_string(resolvedModelCount) + " из " + std::to_string(modelResolutions.size()));
+    for (auto& group : objectGroups) {
+        group.bestModel = selectBestModelForGroup(modelResolutions, sceneInstances, group);
+    }
+
+    stats.groupCount = objectGroups.size();
+    stats.duplicateCount = 0;
+    placements.clear();
+    placements.reserve(objectGroups.size());
+
+    for (size_t groupIndex = 0; groupIndex < objectGroups.size(); groupIndex++) {
+        const auto& group = objectGroups[groupIndex];
+
+        if (groupIndex < 10) {
+            LogModels("Группа #" + std::to_string(groupIndex) + ": " + std::to_string(group.objectIndices.size()) +
+                     " объектов в позиции (" + std::to_string(group.x) + ", " + std::to_string(group.y) + ", " + std::to_string(group.z) + ")");
+
+            // Показываем детали группы для отладки
+            if (group.objectIndices.size() > 1) {
+                LogModels("  Объекты в группе:");
+                for (size_t objIdx : group.objectIndices) {
+                    const std::string& objName = sceneInstances.GetModelName(objIdx);
+                    LogModels("    - " + objName + " (ID: " + std::to_string(sceneInstances.GetModelId(objIdx)) + ")");
+                }
+            }
+
+            // LOD-родитель группы
+            if (group.lodGroup >= 0) {
+                const auto& lodGroup = objectGroups[group.lodGroup];
+                LogModels("  -> LOD: группа #" + std::to_string(group.lodGroup) + " (" +
+                          sceneInstances.GetModelName(lodGroup.objectIndices[0]) + ")");
+            }
+        }
+
+        // Используем координаты группы и поворот первого объекта
+        const size_t firstObj = group.objectIndices[0];
+        const SceneInstanceTable::Quaternion& firstRotation = sceneInstances.GetRotations()[firstObj];
+        // Дальность - по ID из IPL, иначе по имени модели (как в Renderer::ApplyModelDrawDistance)
+        const ide::ObjectDefinition* firstDefinition = definitions.findById(sceneInstances.GetModelId(firstObj));
+        if (!firstDefinition) {
+            firstDefinition = definitions.findByName(sceneInstances.GetModelName(firstObj));
+        }
+        ModelStreamer::Placement placement = { sceneInstances.GetModelName(firstObj), sceneInstances.GetModelId(firstObj), static_cast<int>(groupIndex) + 1,
+                                               group.x, group.y, group.z, firstRotation.x, firstRotation.y, firstRotation.z, firstRotation.w,
+                                               firstDefinition ? firstDefinition->drawDistance : 0.0f,
+                                               group.lodGroup >= 0 ? group.lodGroup + 1 : -1 };
+        if (group.bestModel != SceneInstanceTable::kInvalidModel) {
+            const ModelResolution& best = modelResolutions[group.bestModel];
+            placements.push_back({ best.fileName, std::move(placement), best.entry });
+        }
+        else {
+            placements.push_back({ std::string(), std::move(placement), nullptr });
+        }
+
+        // Подсчитываем дубликаты
+        if (group.objectIndices.size() > 1) {
+            stats.duplicateCount += group.objectIndices.size() - 1;
+        }
+    }
+}
+
+// Разбить командную строку на аргументы (кавычки объединяют аргумент с пробелами)
+std::vector<std::string> splitCommandLine(const char* commandLine) {
+    std::vector<std::string> args;
+    if (!commandLine) {
+        return args;
+    }
+    
+    std::string current;
+    bool inQuotes = false;
+    bool hasArg = false;
+    for (const char* p = commandLine; *p; p++) {
+        if (*p == '"') {
+            inQuotes = !inQuotes;
+            hasArg = true;
+        }
+        else if ((*p == ' ' || *p == '\t') && !inQuotes) {
+            if (hasArg) {
+                args.push_back(current);
+                current.clear();
+                hasArg = false;
+            }
+        }
+        else {
+            current += *p;
+            hasArg = true;
+        }
+    }
+    if (hasArg) {
+        args.push_back(current);
+    }
+    
+    return args;
+}
+
+// Проверить наличие ключа командной строки
+bool hasCommandLineFlag(const std::vector<std::string>& args, const std::string& flag) {
+    return std::find(args.begin(), args.end(), flag) != args.end();
+}
+
+// Результат замера загрузки районов из одного архива
+struct RegionLoadStats {
+    size_t regions = 0;     // Районов с моделями из архива
+    size_t files = 0;       // Прочитано файлов
+    size_t seeks = 0;       // Последовательных чтений (каждое начинается с перехода по файлу)
+    double readMs = 0.0;    // Суммарное время чтения
+};
+
+// Замер загрузки районов: объекты IPL делятся на квадраты regionSize x regionSize,
+// модели каждого района читаются одним пакетом без слияния через разрывы
+RegionLoadStats measureRegionLoads(const img::ImgData& archive, const std::vector<ipl::IplObject>& objects, float regionSize) {
+    RegionLoadStats stats;
+    
+    // Индекс по одному архиву - для поиска без учета регистра
+    img::AssetIndex archiveIndex;
+    archiveIndex.build({ const_cast<img::ImgData*>(&archive) });
+    
+    std::map<std::pair<int, int>, std::vector<size_t>> regions;
+    for (size_t i = 0; i < objects.size(); i++) {
+        int cellX = static_cast<int>(std::floor(objects[i].x / regionSize));
+        int cellY = static_cast<int>(std::floor(objects[i].y / regionSize));
+        regions[{ cellX, cellY }].push_back(i);
+    }
+    
+    for (const auto& region : regions) {
+        // Уникальные файлы района в регистре каталога архива
+        std::vector<std::string> names;
+        std::map<uint32_t, bool> seenEntries;
+        for (size_t objIndex : region.second) {
+            const std::string& baseName = objects[objIndex].name;
+            for (const std::string& fileName : { "lod" + baseName + ".dff", baseName + ".dff" }) {
+                const img::AssetIndex::Entry* entry = archiveIndex.find(fileName);
+                if (entry && !seenEntries[entry->entry]) {
+                    seenEntries[entry->entry] = true;
+                    const char* entryName = archive.getEntryName(entry->entry);
+                    names.push_back(std::string(entryName, strnlen(entryName, 24)));
+                }
+            }
+        }
+        if (names.empty()) {
+            continue;
+        }
+        
+        auto start = std::chrono::high_resolution_clock::now();
+        img::ImgBatch batch;
+        archive.fetchBatch(names, batch, 0);
+        stats.readMs += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        
+        stats.regions++;
+        stats.files += names.size();
+        stats.seeks += batch.runCount;
+    }
+    
+    return stats;
+}
+
+// Инструмент переупаковки IMG по положению моделей в мире с замером до/после
+bool runImgRepackTool(const std::string& sourcePath, const std::string& outputPath, const std::vector<ipl::IplObject>& objects) {
+    LogImg("Переупаковка IMG: " + sourcePath + " -> " + outputPath);
+    
+    // Исходный архив отображается в память: записи копируются в новый файл из представлений
+    img::ImgData source;
+    if (!source.loadImgFile(sourcePath.c_str(), img::ImgLoadMode::Mapped)) {
+        LogError("Не удалось открыть исходный архив: " + sourcePath);
+        return false;
+    }
+    
+    img::RepackStats repackStats;
+    if (!img::repackImgSpatial(source, objects, outputPath.c_str(), &repackStats)) {
+        LogError("Не удалось переупаковать архив: " + sourcePath);
+        return false;
+    }
+    LogImg("Записано: " + std::to_string(repackStats.placedEntries) + " файлов по кривой Мортона, " + 
+           std::to_string(repackStats.unplacedEntries) + " без размещений в конце (" + 
+           std::to_string(img::sectorsToBytes(repackStats.outputSectors) / (1024 * 1024)) + " МБ)");
+    
+    // Замер идет через чтение файла (ленивое открытие), а не через отображение
+    img::ImgData original;
+    img::ImgData repacked;
+    if (!original.loadImgFile(sourcePath.c_str(), img::ImgLoadMode::Lazy) ||
+        !repacked.loadImgFile(outputPath.c_str(), img::ImgLoadMode::Lazy)) {
+        LogError("Не удалось открыть архивы для замера: " + sourcePath + ", " + outputPath);
+        return false;
+    }
+    
+    // Оба архива читаются через файловый кэш ОС (переупакованный только что записан), поэтому время -
+    // лишь ориентир; сравнивается в первую очередь число переходов
+    const float regionSize = 500.0f;
+    RegionLoadStats before = measureRegionLoads(original, objects, regionSize);
+    RegionLoadStats after = measureRegionLoads(repacked, objects, regionSize);
+    
+    LogImg("Загрузка районов " + std::to_string(static_cast<int>(regionSize)) + "x" + std::to_string(static_cast<int>(regionSize)) + 
+           " (" + std::to_string(before.regions) + " районов, " + std::to_string(before.files) + " файлов):");
+    LogImg("  Исходный архив: переходов " + std::to_string(before.seeks) + ", чтение " + std::to_string(before.readMs) + " мс (с кэшем ОС)");
+    LogImg("  Переупакованный: переходов " + std::to_string(after.seeks) + ", чтение " + std::to_string(after.readMs) + " мс (с кэшем ОС)");
+    if (after.seeks > 0) {
+        LogImg("  Переходов меньше в " + std::to_string(static_cast<double>(before.seeks) / after.seeks) + " раз");
+    }
+    
+    return true;
+}
+
+// Сравнить два объекта IPL поле за полем (координаты и повороты - побитово)
+bool iplObjectsEqual(const ipl::IplObject& a, const ipl::IplObject& b) {
+    return a.modelId == b.modelId && a.name == b.name && a.interior == b.interior && a.lod == b.lod &&
+           std::bit_cast<uint32_t>(a.x) == std::bit_cast<uint32_t>(b.x) &&
+           std::bit_cast<uint32_t>(a.y) == std::bit_cast<uint32_t>(b.y) &&
+           std::bit_cast<uint32_t>(a.z) == std::bit_cast<uint32_t>(b.z) &&
+           std::bit_cast<uint32_t>(a.rx) == std::bit_cast<uint32_t>(b.rx) &&
+           std::bit_cast<uint32_t>(a.ry) == std::bit_cast<uint32_t>(b.ry) &&
+           std::bit_cast<uint32_t>(a.rz) == std::bit_cast<uint32_t>(b.rz) &&
+           std::bit_cast<uint32_t>(a.rw) == std::bit_cast<uint32_t>(b.rw);
+}
+
+// Бенчмарк разбора строк INST: синтетический IPL из lineCount строк разбирается прежним
+// парсером (istringstream на строку) и новым (string_view + from_chars), результаты сравниваются
+bool runIplParseBenchmark(size_t lineCount) {
+    LogIpl("Бенчмарк разбора INST: генерация " + std::to_string(lineCount) + " строк");
+    
+    // Детерминированные данные в формате SA, с разной точностью и лишними пробелами
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> position(-3000.0f, 3000.0f);
+    std::uniform_real_distribution<float> rotation(-1.0f, 1.0f);
+    std::string text = "# synthetic ipl\ninst\n";
+    std::vector<std::string> lines;
+    lines.reserve(lineCount);
+    char line[256];
+    for (size_t i = 0; i < lineCount; i++) {
+        const char* format = (i % 7 == 0)
+            ? "%d,  obj_%05zu_lod ,\t%d, %.3f, %.3f, %.3f, %g, %g, %g, %g, %d"
+            : "%d, obj_%05zu, %d, %.5f, %.5f, %.5f, %.6f, %.6f, %.6f, %.6f, %d";
+        snprintf(line, sizeof(line), format, 600 + static_cast<int>(i % 18000), i, static_cast<int>(i % 19),
+                 position(random), position(random), position(random) * 0.05f,
+                 rotation(random), rotation(random), rotation(random), rotation(random),
+                 (i % 3 == 0) ? -1 : static_cast<int>(i % 5000));
+        lines.push_back(line);
+        text += line;
+        text += "\n";
+    }
+    text += "end\n";
+    
+    // Лучшее время из нескольких прогонов
+    const int runs = 3;
+    double legacyMs = 0.0, fastMs = 0.0;
+    std::vector<ipl::IplObject> legacyObjects;
+    ipl::IplData fastData;
+    for (int run = 0; run < runs; run++) {
+        legacyObjects.clear();
+        legacyObjects.reserve(lineCount);
+        auto legacyStart = std::chrono::high_resolution_clock::now();
+        for (const auto& source : lines) {
+            ipl::IplObject object(0, "", 0, 0, 0, 0, 0, 0, 0, 0, 0);
+            if (ipl::parseInstLineLegacy(source, object)) {
+                legacyObjects.push_back(object);
+            }
+        }
+        double runLegacyMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - legacyStart).count();
         
-        if (!modelName.empty()) {
-            // Проверяем, является ли это LOD версией (приписка "lod" в начале)
-            if (modelName.find("lod") == 0) { // "lod" в самом начале названия
-                if (!hasLod || bestModelName.empty()) {
-                    bestModelName = modelName;
-                    hasLod = true;
-                    LogModels("Выбрана LOD версия для группы: " + modelName);
+        fastData.clear();
+        auto fastStart = std::chrono::high_resolution_clock::now();
+        ipl::parseIplText(text, fastData);
+        double runFastMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - fastStart).count();
+        
+        legacyMs = (run == 0) ? runLegacyMs : std::min(legacyMs, runLegacyMs);
+        fastMs = (run == 0) ? runFastMs : std::min(fastMs, runFastMs);
+    }
+    
+    // Результаты должны совпасть полностью
+    const auto& fastObjects = fastData.getAllObjects();
+    size_t mismatches = (legacyObjects.size() == fastObjects.size()) ? 0 : 1;
+    for (size_t i = 0; i < std::min(legacyObjects.size(), fastObjects.size()); i++) {
+        if (!iplObjectsEqual(legacyObjects[i], fastObjects[i])) {
+            if (mismatches == 0) {
+                LogError("Расхождение в строке " + std::to_string(i) + ": " + lines[i]);
+            }
+            mismatches++;
+        }
+    }
+    
+    // Те же объекты в бинарном формате ("bnry") - записи фиксированного размера
+    std::vector<uint8_t> binary(sizeof(ipl::BinaryIplHeader) + legacyObjects.size() * sizeof(ipl::BinaryIplInstance));
+    ipl::BinaryIplHeader binaryHeader = {};
+    memcpy(binaryHeader.magic, "bnry", 4);
+    binaryHeader.instanceCount = static_cast<int32_t>(legacyObjects.size());
+    binaryHeader.instanceOffset = sizeof(ipl::BinaryIplHeader);
+    memcpy(binary.data(), &binaryHeader, sizeof(binaryHeader));
+    for (size_t i = 0; i < legacyObjects.size(); i++) {
+        const auto& object = legacyObjects[i];
+        ipl::BinaryIplInstance instance = { object.x, object.y, object.z, object.rx, object.ry, object.rz, object.rw,
+                                            object.modelId, object.interior, object.lod };
+        memcpy(binary.data() + sizeof(binaryHeader) + i * sizeof(instance), &instance, sizeof(instance));
+    }
+    
+    double binaryMs = 0.0;
+    ipl::IplData binaryData;
+    for (int run = 0; run < runs; run++) {
+        binaryData.clear();
+        auto binaryStart = std::chrono::high_resolution_clock::now();
+        ipl::loadBinaryIpl(binary, binaryData);
+        double runBinaryMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - binaryStart).count();
+        binaryMs = (run == 0) ? runBinaryMs : std::min(binaryMs, runBinaryMs);
+    }
+    
+    // В бинарном формате нет имен - сравниваем остальные поля
+    const auto& binaryObjects = binaryData.getAllObjects();
+    size_t binaryMismatches = (legacyObjects.size() == binaryObjects.size()) ? 0 : 1;
+    for (size_t i = 0; i < std::min(legacyObjects.size(), binaryObjects.size()); i++) {
+        ipl::IplObject named = binaryObjects[i];
+        named.name = legacyObjects[i].name;
+        if (!iplObjectsEqual(legacyObjects[i], named)) {
+            binaryMismatches++;
+        }
+    }
+    
+    LogIpl("  Прежний парсер: " + std::to_string(legacyObjects.size()) + " объектов, " + std::to_string(legacyMs) + " мс");
+    LogIpl("  Новый парсер:   " + std::to_string(fastObjects.size()) + " объектов, " + std::to_string(fastMs) + " мс");
+    LogIpl("  Бинарный IPL:   " + std::to_string(binaryObjects.size()) + " объектов, " + std::to_string(binaryMs) + " мс");
+    if (fastMs > 0.0) {
+        LogIpl("  Ускорение: " + std::to_string(legacyMs / fastMs) + "x");
+    }
+    if (binaryMs > 0.0) {
+        LogIpl("  Бинарный быстрее текстового: " + std::to_string(fastMs / binaryMs) + "x (прежнего - " + 
+               std::to_string(legacyMs / binaryMs) + "x)");
+    }
+    if (binaryMismatches != 0) {
+        LogError("Бинарный IPL отличается от текстового: " + std::to_string(binaryMismatches) + " объектов");
+        return false;
+    }
+    if (mismatches != 0) {
+        LogError("Результаты парсеров различаются: " + std::to_string(mismatches) + " объектов");
+        return false;
+    }
+    LogIpl("  Результаты совпадают");
+    return true;
+}
+
+// Бенчмарк группировки: пространственный хэш против прежнего O(n^2) прохода на одинаковых данных.
+// Группы должны совпасть полностью - порядок, точки, уровень и состав
+bool runGroupingBenchmark(size_t objectCount) {
+    LogSystem("Бенчмарк группировки: генерация " + std::to_string(objectCount) + " объектов");
+
+    // Детерминированная сцена: часть объектов - повторы ранее поставленных со сдвигом до 1.5
+    // (включая сдвиг ровно на порог), координаты кратны 1/4, чтобы попадать на границы ячеек
+    std::mt19937 random(54321);
+    std::uniform_int_distribution<int> position(-12000, 12000);
+    std::uniform_int_distribution<int> offset(-6, 6);
+    SceneInstanceTable objects;
+    objects.Reserve(objectCount);
+    uint32_t model = objects.InternModel("obj", -1);
+    for (size_t i = 0; i < objectCount; i++) {
+        float x, y, z;
+        if (i > 0 && random() % 5 < 2) {
+            size_t source = random() % i;
+            x = objects.GetX()[source] + offset(random) * 0.25f;
+            y = objects.GetY()[source] + offset(random) * 0.25f;
+            z = objects.GetZ()[source] + offset(random) * 0.25f;
+        }
+        else {
+            x = position(random) * 0.25f;
+            y = position(random) * 0.25f;
+            z = (position(random) % 400) * 0.25f;
+        }
+        objects.AddInstance(model, x, y, z, { 0.0f, 0.0f, 0.0f, 1.0f });
+    }
+    std::vector<uint8_t> isLodInstance(objectCount, 0);
+    for (size_t i = 0; i < objectCount; i += 7) {
+        isLodInstance[i] = 1;
+    }
+
+    auto legacyStart = std::chrono::high_resolution_clock::now();
+    std::vector<ObjectGroup> legacyGroups = groupObjectsByCoordinatesLegacy(objects, isLodInstance, 1.0f);
+    double legacyMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - legacyStart).count();
+
+    ThreadPool pool;
+    double hashMs = 0.0;
+    std::vector<ObjectGroup> hashGroups;
+    for (int run = 0; run < 3; run++) {
+        auto hashStart = std::chrono::high_resolution_clock::now();
+        hashGroups = groupObjectsByCoordinates(objects, isLodInstance, 1.0f, &pool);
+        double runMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - hashStart).count();
+        hashMs = (run == 0) ? runMs : std::min(hashMs, runMs);
+    }
+
+    size_t mismatches = legacyGroups.size() == hashGroups.size() ? 0 : 1;
+    for (size_t i = 0; i < std::min(legacyGroups.size(), hashGroups.size()); i++) {
+        const ObjectGroup& a = legacyGroups[i];
+        const ObjectGroup& b = hashGroups[i];
+        if (a.x != b.x || a.y != b.y || a.z != b.z || a.isLod != b.isLod || a.objectIndices != b.objectIndices) {
+            mismatches++;
+        }
+    }
+
+    LogSystem("  Групп: " + std::to_string(legacyGroups.size()));
+    LogSystem("  Прежняя группировка: " + std::to_string(legacyMs) + " мс");
+    LogSystem("  Пространственный хэш (" + std::to_string(pool.GetThreadCount()) + " потоков): " + std::to_string(hashMs) + " мс");
+    if (hashMs > 0.0) {
+        LogSystem("  Ускорение: " + std::to_string(legacyMs / hashMs) + "x");
+    }
+    if (mismatches != 0) {
+        LogError("Группы различаются: " + std::to_string(mismatches));
+        return false;
+    }
+    LogSystem("  Результаты совпадают");
+    return true;
+}
+
+// Путь к DFF модели размещения в папке unpack (пусто - файла нет или он уже не разобрался).
+// Папка unpack проиндексирована один раз; имена без рабочей модели в ней отсекаются сразу
+std::string findUnpackModel(const ModelStreamer::Placement& placement) {
+    UnpackIndex& unpack = AssetCache::Unpack();
+    return unpack.IsMissing(placement.objectName) ? std::string() : unpack.FindModel(placement.objectName);
+}
+
+// Fallback для размещения без модели в IMG с уже разобранной моделью из unpack (nullptr - куб).
+// Возвращает true, если поставлена модель из unpack.
+bool addFallbackModel(Renderer& renderer, const ModelStreamer::Placement& placement, const std::string& unpackPath,
+                      const std::shared_ptr<const dff::DffModel>& model, bool verbose) {
+    if (model) {
+        renderer.AddDffModel(AssetCache::MakeFileKey(unpackPath), model, placement.objectName.c_str(), placement.x, placement.y, placement.z, 
+                             placement.rx, placement.ry, placement.rz, placement.rw, placement.groupIndex, placement.lodGroupIndex);
+        if (verbose) {
+            LogSuccess("DFF модель загружена из unpack для группы: " + placement.objectName + " (путь: " + unpackPath + ")");
+        }
+        return true;
+    }
+    if (!unpackPath.empty()) {
+        AssetCache::Unpack().MarkMissing(placement.objectName);
+    }
+    
+    renderer.AddTestObject(placement.groupIndex, placement.modelId, placement.objectName.c_str(), 
+                           placement.x, placement.y, placement.z, placement.rx, placement.ry, placement.rz, placement.rw);
+    if (verbose) {
+        LogWarning("Создан fallback куб для группы в позиции (" + 
+                   std::to_string(placement.x) + ", " + std::to_string(placement.y) + ", " + std::to_string(placement.z) + ")");
+    }
+    return false;
+}
+
+// Fallback для размещения без модели в IMG: DFF из папки unpack, иначе куб.
+// Возвращает true, если загружена модель из unpack.
+bool addFallbackModel(Renderer& renderer, const ModelStreamer::Placement& placement, bool verbose) {
+    // Одна и та же модель из unpack нужна многим группам - разбирается один раз (через кэш)
+    std::string unpackPath = findUnpackModel(placement);
+    auto model = unpackPath.empty() ? nullptr : AssetCache::LoadDffFile(unpackPath);
+    return addFallbackModel(renderer, placement, unpackPath, model, verbose);
+}
+
+// Разобрать DFF файлы с диска через кэш: каждый - в свой слот результата, параллельно при наличии пула.
+// Разбор не трогает OpenGL - загрузка в GPU остается за основным потоком
+std::vector<std::shared_ptr<const dff::DffModel>> decodeDffFiles(const std::vector<std::string>& paths, ThreadPool* pool) {
+    std::vector<std::shared_ptr<const dff::DffModel>> models(paths.size());
+    
+    auto decodeOne = [&](size_t i) {
+        models[i] = AssetCache::LoadDffFile(paths[i]);
+    };
+    if (pool) {
+        pool->ParallelFor(paths.size(), decodeOne);
+    }
+    else {
+        for (size_t i = 0; i < paths.size(); i++) {
+            decodeOne(i);
+        }
+    }
+    
+    return models;
+}
+
+// Результат разбора одного IPL файла (заполняется в рабочем потоке)
+struct IplLoadResult {
+    bool loaded = false;
+    ipl::IplData data;
+};
+
+// Разобрать IPL файлы: каждый файл - в свой буфер, параллельно при наличии пула
+std::vector<IplLoadResult> loadIplFiles(const std::vector<GtaDatEntry>& iplEntries, ThreadPool* pool) {
+    std::vector<IplLoadResult> results(iplEntries.size());
+    
+    auto loadOne = [&](size_t i) {
+        results[i].loaded = ipl::loadIplFile(iplEntries[i].path.c_str(), results[i].data);
+    };
+    if (pool) {
+        pool->ParallelFor(iplEntries.size(), loadOne);
+    }
+    else {
+        for (size_t i = 0; i < iplEntries.size(); i++) {
+            loadOne(i);
+        }
+    }
+    
+    return results;
+}
+
+// Слить объекты в порядке gta.dat в один заранее выделенный массив (буферы файлов опустошаются).
+// Поле lod - индекс LOD объекта внутри своего файла (у бинарных IPL - внутри текстового владельца,
+// объекты которого идут в буфере первыми); после слияния оно становится индексом в общем массиве
+std::vector<ipl::IplObject> mergeIplResults(std::vector<IplLoadResult>& results) {
+    size_t totalObjects = 0;
+    for (const auto& result : results) {
+        totalObjects += result.data.getObjectCount();
+    }
+    
+    std::vector<ipl::IplObject> allObjects;
+    allObjects.reserve(totalObjects);
+    for (auto& result : results) {
+        std::vector<ipl::IplObject> objects = result.data.takeObjects();
+        const int fileBase = static_cast<int>(allObjects.size());
+        for (auto& object : objects) {
+            object.lod = (object.lod >= 0 && static_cast<size_t>(object.lod) < objects.size()) ? fileBase + object.lod : -1;
+        }
+        allObjects.insert(allObjects.end(), std::make_move_iterator(objects.begin()), std::make_move_iterator(objects.end()));
+    }
+    return allObjects;
+}
+
+// Разобрать IDE файлы (каждый - в свою таблицу, параллельно при наличии пула) и слить их
+// в порядке gta.dat: определение из более позднего файла перекрывает раннее
+ide::IdeData loadIdeFiles(const std::vector<GtaDatEntry>& ideEntries, ThreadPool* pool) {
+    std::vector<ide::IdeData> fileData(ideEntries.size());
+    std::vector<char> loaded(ideEntries.size(), 0);
+    
+    auto loadOne = [&](size_t i) {
+        loaded[i] = ide::loadIdeFile(ideEntries[i].path.c_str(), fileData[i]);
+    };
+    if (pool) {
+        pool->ParallelFor(ideEntries.size(), loadOne);
+    }
+    else {
+        for (size_t i = 0; i < ideEntries.size(); i++) {
+            loadOne(i);
+        }
+    }
+    
+    ide::IdeData definitions;
+    for (size_t i = 0; i < ideEntries.size(); i++) {
+        if (!loaded[i]) {
+            LogModels("ОШИБКА: Не удалось загрузить IDE файл: " + ideEntries[i].path);
+            continue;
+        }
+        definitions.merge(fileData[i]);
+    }
+    return definitions;
+}
+
+// Итог подключения потоковых бинарных IPL
+struct StreamedIplStats {
+    size_t files = 0;       // Прочитано бинарных IPL
+    size_t objects = 0;     // Добавлено объектов
+    size_t unnamed = 0;     // Пропущено: ID модели нет ни в IDE, ни в текстовых IPL
+};
+
+// Потоковые бинарные IPL из IMG (<имя>_streamN.ipl) дописываются к своему текстовому IPL.
+// В бинарной записи нет имени модели - оно берется из IDE, а для ID без определения -
+// у объектов текстовых IPL с тем же ID.
+StreamedIplStats attachStreamedIpls(const img::AssetIndex& assetIndex, const ide::IdeData& definitions,
+                                    const std::vector<GtaDatEntry>& iplEntries,
+                                    std::vector<IplLoadResult>& results, ThreadPool* pool) {
+    // ID модели -> имя (первое встреченное в текстовых IPL)
+    std::map<int, std::string> namesById;
+    for (const auto& result : results) {
+        for (const auto& object : result.data.getAllObjects()) {
+            namesById.emplace(object.modelId, object.name);
+        }
+    }
+    
+    std::vector<StreamedIplStats> fileStats(results.size());
+    auto attachOne = [&](size_t i) {
+        // Имя текстового IPL без папки и расширения: DATA\MAPS\LA\LAe.IPL -> lae
+        std::string baseName = iplEntries[i].path;
+        size_t slash = baseName.find_last_of("\\/");
+        if (slash != std::string::npos) {
+            baseName = baseName.substr(slash + 1);
+        }
+        baseName = baseName.substr(0, baseName.find_last_of('.'));
+        
+        ipl::IplData streamed;
+        for (int part = 0; ; part++) {
+            std::span<const uint8_t> data = assetIndex.getView(baseName + "_stream" + std::to_string(part) + ".ipl");
+            if (data.empty()) {
+                break;
+            }
+            if (ipl::loadBinaryIpl(data, streamed)) {
+                fileStats[i].files++;
+            }
+        }
+        
+        results[i].data.reserveObjects(streamed.getObjectCount());
+        for (auto& object : streamed.takeObjects()) {
+            if (const ide::ObjectDefinition* definition = definitions.findById(object.modelId)) {
+                object.name = definition->modelName;
+            }
+            else {
+                auto nameIt = namesById.find(object.modelId);
+                if (nameIt == namesById.end()) {
+                    fileStats[i].unnamed++;
+                    continue;
+                }
+                object.name = nameIt->second;
+            }
+            results[i].data.addObject(object);
+            fileStats[i].objects++;
+        }
+    };
+    
+    if (pool) {
+        pool->ParallelFor(results.size(), attachOne);
+    }
+    else {
+        for (size_t i = 0; i < results.size(); i++) {
+            attachOne(i);
+        }
+    }
+    
+    StreamedIplStats stats;
+    for (const auto& fileStat : fileStats) {
+        stats.files += fileStat.files;
+        stats.objects += fileStat.objects;
+        stats.unnamed += fileStat.unnamed;
+    }
+    return stats;
+}
+
+// Бенчмарк масштабирования загрузки IPL: файлы в секунду для 1..N потоков,
+// результат каждого прогона сверяется с последовательной загрузкой
+bool runIplScalingBenchmark(const std::vector<GtaDatEntry>& iplEntries) {
+    if (iplEntries.empty()) {
+        LogError("Бенчмарк загрузки IPL: в gta.dat нет IPL файлов");
+        return false;
+    }
+    
+    std::vector<IplLoadResult> referenceResults = loadIplFiles(iplEntries, nullptr);
+    std::vector<ipl::IplObject> reference = mergeIplResults(referenceResults);
+    LogIpl("Бенчмарк загрузки IPL: " + std::to_string(iplEntries.size()) + " файлов, " + std::to_string(reference.size()) + " объектов");
+    
+    // 1, 2, 4, ... и число аппаратных потоков
+    unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> threadCounts;
+    for (size_t threads = 1; threads < hardwareThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(hardwareThreads);
+    
+    const int runs = 3;
+    bool identical = true;
+    double singleThreadMs = 0.0;
+    for (size_t threads : threadCounts) {
+        ThreadPool pool(threads);
+        
+        // Лучшее время из нескольких прогонов (разбор + слияние)
+        double bestMs = 0.0;
+        for (int run = 0; run < runs; run++) {
+            auto start = std::chrono::high_resolution_clock::now();
+            std::vector<IplLoadResult> results = loadIplFiles(iplEntries, &pool);
+            std::vector<ipl::IplObject> merged = mergeIplResults(results);
+            double runMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+            bestMs = (run == 0) ? runMs : std::min(bestMs, runMs);
+            
+            bool sameObjects = merged.size() == reference.size();
+            for (size_t i = 0; sameObjects && i < merged.size(); i++) {
+                sameObjects = iplObjectsEqual(merged[i], reference[i]);
+            }
+            if (!sameObjects) {
+                LogError("Результат при " + std::to_string(threads) + " потоках отличается от последовательной загрузки");
+                identical = false;
+            }
+        }
+        
+        if (threads == 1) {
+            singleThreadMs = bestMs;
+        }
+        double filesPerSecond = bestMs > 0.0 ? iplEntries.size() * 1000.0 / bestMs : 0.0;
+        LogIpl("  Потоков " + std::to_string(threads) + ": " + std::to_string(bestMs) + " мс, " + 
+               std::to_string(static_cast<int>(filesPerSecond)) + " файлов/с" + 
+               (bestMs > 0.0 ? ", ускорение " + std::to_string(singleThreadMs / bestMs) + "x" : ""));
+    }
+    
+    if (identical) {
+        LogIpl("  Результаты совпадают с последовательной загрузкой");
+    }
+    return identical;
+}
+
+// Результат открытия одного IMG архива (заполняется в рабочем потоке)
+struct ImgOpenResult {
+    img::ImgData* imgData = nullptr;   // nullptr - архив не открылся
+    bool fileFound = false;            // Файл архива существует
+    double openMs = 0.0;               // Время открытия этого архива
+};
+
+// Открыть один IMG архив: проверка файла, заголовок, каталог и отображение в память
+ImgOpenResult openImgArchive(const std::string& path) {
+    ImgOpenResult result;
+    auto start = std::chrono::high_resolution_clock::now();
+    
+    FILE* testFile = fopen(path.c_str(), "rb");
+    if (testFile) {
+        fclose(testFile);
+        result.fileFound = true;
+        
+        img::ImgData* imgData = new img::ImgData();
+        if (img::loadImgFile(path.c_str(), *imgData, img::ImgLoadMode::Mapped)) {
+            result.imgData = imgData;
+        }
+        else {
+            delete imgData;
+        }
+    }
+    
+    result.openMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    return result;
+}
+
+// Открыть все IMG архивы. Результат лежит в порядке imgEntries независимо от порядка завершения
+// потоков, поэтому приоритет архивов тот же, что и при последовательной загрузке.
+std::vector<ImgOpenResult> openImgArchives(const std::vector<GtaDatEntry>& imgEntries, ThreadPool* pool) {
+    std::vector<ImgOpenResult> results(imgEntries.size());
+    
+    if (pool) {
+        pool->ParallelFor(imgEntries.size(), [&](size_t i) {
+            results[i] = openImgArchive(imgEntries[i].path);
+        });
+    }
+    else {
+        for (size_t i = 0; i < imgEntries.size(); i++) {
+            results[i] = openImgArchive(imgEntries[i].path);
+        }
+    }
+    
+    return results;
+}
+
+// Сводка разобранной модели для сверки прогонов бенчмарка
+struct DffDecodeSummary {
+    bool decoded = false;
+    size_t vertexCount = 0;
+    size_t polygonCount = 0;
+    uint32_t cacheMissesBefore = 0;     // Промахи кэша вершин в порядке из файла
+    uint32_t cacheMissesAfter = 0;      // После переупорядочивания при импорте
+    
+    bool operator==(const DffDecodeSummary& other) const {
+        return decoded == other.decoded && vertexCount == other.vertexCount && polygonCount == other.polygonCount &&
+               cacheMissesBefore == other.cacheMissesBefore && cacheMissesAfter == other.cacheMissesAfter;
+    }
+};
+
+// Разобрать DFF из представлений IMG: каждая модель - в свой слот, параллельно при наличии пула
+std::vector<DffDecodeSummary> decodeDffViews(const std::vector<img::ImgFileView>& views, ThreadPool* pool) {
+    std::vector<DffDecodeSummary> summaries(views.size());
+    
+    auto decodeOne = [&](size_t i) {
+        dff::DffData dffData;
+        if (dffData.loadDffFromBuffer(views[i].data, std::string(views[i].name))) {
+            summaries[i].decoded = true;
+            summaries[i].vertexCount = dffData.getModel().getVertexCount();
+            summaries[i].polygonCount = dffData.getModel().getPolygonCount();
+            summaries[i].cacheMissesBefore = dffData.getModel().cacheMissesBefore;
+            summaries[i].cacheMissesAfter = dffData.getModel().cacheMissesAfter;
+        }
+    };
+    if (pool) {
+        pool->ParallelFor(views.size(), decodeOne);
+    }
+    else {
+        for (size_t i = 0; i < views.size(); i++) {
+            decodeOne(i);
+        }
+    }
+    
+    return summaries;
+}
+
+// Бенчмарк масштабирования разбора DFF: все модели IMG архивов для 1..N потоков,
+// результат каждого прогона сверяется с последовательным разбором
+bool runDffDecodeBenchmark(const std::vector<GtaDatEntry>& imgEntries) {
+    std::vector<ImgOpenResult> archives = openImgArchives(imgEntries, nullptr);
+    std::vector<img::ImgFileView> views;
+    for (const auto& archive : archives) {
+        if (archive.imgData) {
+            std::vector<img::ImgFileView> archiveViews = archive.imgData->getFileViewsByExtension(".dff");
+            views.insert(views.end(), archiveViews.begin(), archiveViews.end());
+        }
+    }
+    
+    bool identical = !views.empty();
+    if (views.empty()) {
+        LogError("Бенчмарк разбора DFF: в IMG архивах нет DFF моделей");
+    }
+    else {
+        std::vector<DffDecodeSummary> reference = decodeDffViews(views, nullptr);
+        size_t decodedCount = std::count_if(reference.begin(), reference.end(), [](const DffDecodeSummary& summary) { return summary.decoded; });
+        LogModels("Бенчмарк разбора DFF: " + std::to_string(views.size()) + " моделей, разобрано " + std::to_string(decodedCount));
+        
+        // Средний ACMR (промахи кэша вершин на треугольник) по всем разобранным моделям
+        uint64_t totalPolygons = 0, totalMissesBefore = 0, totalMissesAfter = 0;
+        for (const auto& summary : reference) {
+            totalPolygons += summary.polygonCount;
+            totalMissesBefore += summary.cacheMissesBefore;
+            totalMissesAfter += summary.cacheMissesAfter;
+        }
+        if (totalPolygons > 0) {
+            LogModels("  ACMR: в порядке из файла " + std::to_string(static_cast<double>(totalMissesBefore) / totalPolygons) +
+                      ", после переупорядочивания " + std::to_string(static_cast<double>(totalMissesAfter) / totalPolygons) +
+                      " (" + std::to_string(totalPolygons) + " треугольников)");
+        }
+        
+        // 1, 2, 4, ... и число аппаратных потоков
+        unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<size_t> threadCounts;
+        for (size_t threads = 1; threads < hardwareThreads; threads *= 2) {
+            threadCounts.push_back(threads);
+        }
+        threadCounts.push_back(hardwareThreads);
+        
+        const int runs = 3;
+        double singleThreadMs = 0.0;
+        for (size_t threads : threadCounts) {
+            ThreadPool pool(threads);
+            
+            double bestMs = 0.0;
+            for (int run = 0; run < runs; run++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                std::vector<DffDecodeSummary> summaries = decodeDffViews(views, &pool);
+                double runMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+                bestMs = (run == 0) ? runMs : std::min(bestMs, runMs);
+                
+                if (summaries != reference) {
+                    LogError("Результат при " + std::to_string(threads) + " потоках отличается от последовательного разбора");
+                    identical = false;
                 }
-            } else if (!hasLod && bestModelName.empty()) {
-                // Берем обычную версию только если LOD не найден
-                bestModelName = modelName;
-                LogModels("Выбрана обычная версия для группы: " + modelName);
             }
+            
+            if (threads == 1) {
+                singleThreadMs = bestMs;
+            }
+            double modelsPerSecond = bestMs > 0.0 ? views.size() * 1000.0 / bestMs : 0.0;
+            LogModels("  Потоков " + std::to_string(threads) + ": " + std::to_string(bestMs) + " мс, " + 
+                      std::to_string(static_cast<int>(modelsPerSecond)) + " моделей/с" + 
+                      (bestMs > 0.0 ? ", ускорение " + std::to_string(singleThreadMs / bestMs) + "x" : ""));
+        }
+        
+        if (identical) {
+            LogModels("  Результаты совпадают с последовательным разбором");
         }
     }
     
-    return bestModelName;
+    for (auto& archive : archives) {
+        delete archive.imgData;
+    }
+    return identical;
 }
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
@@ -241,6 +1291,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
  // ЭТАП 1: ЗАГРУЗКА ДАННЫХ ИЗ DAT ФАЙЛА
  // ============================================================================
 
+    auto sceneLoadStart = std::chrono::high_resolution_clock::now();
     GtaDatData gtaData;
     if (!dat::loadGtaDat("data\\gta.dat", gtaData)) {
         LogSystem("ОШИБКА: Не удалось загрузить gta.dat");
@@ -251,7 +1302,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     // Получаем все записи из DAT файла
     auto iplEntries = gtaData.getEntriesByType(DataType::IPL);
     auto imgEntries = gtaData.getEntriesByType(DataType::IMG);
+    auto ideEntries = gtaData.getEntriesByType(DataType::IDE);
     
+    LogSystem("Найдено IDE файлов: " + std::to_string(ideEntries.size()));
     LogSystem("Найдено IPL файлов: " + std::to_string(iplEntries.size()));
     LogSystem("Найдено IMG файлов: " + std::to_string(imgEntries.size()));
 
@@ -272,45 +1325,115 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         LogImg("ПРЕДУПРЕЖДЕНИЕ: В папке models не найдено .img файлов");
     }
 
+    // Ключи командной строки
+    std::vector<std::string> commandLineArgs = splitCommandLine(lpCmdLine);
+    
+    // Бенчмарк разбора IPL: --bench-ipl [количество строк]
+    auto benchIplArg = std::find(commandLineArgs.begin(), commandLineArgs.end(), "--bench-ipl");
+    if (benchIplArg != commandLineArgs.end()) {
+        size_t lineCount = 200000;
+        if (std::distance(benchIplArg, commandLineArgs.end()) >= 2) {
+            lineCount = std::max<size_t>(1, std::strtoull((benchIplArg + 1)->c_str(), nullptr, 10));
+        }
+        bool benchOk = runIplParseBenchmark(lineCount);
+        renderer.Shutdown();
+        return benchOk ? 0 : -1;
+    }
+    
+    // Бенчмарк группировки объектов: --bench-grouping [количество объектов]
+    auto benchGroupingArg = std::find(commandLineArgs.begin(), commandLineArgs.end(), "--bench-grouping");
+    if (benchGroupingArg != commandLineArgs.end()) {
+        size_t objectCount = 50000;
+        if (std::distance(benchGroupingArg, commandLineArgs.end()) >= 2) {
+            objectCount = std::max<size_t>(1, std::strtoull((benchGroupingArg + 1)->c_str(), nullptr, 10));
+        }
+        bool benchOk = runGroupingBenchmark(objectCount);
+        renderer.Shutdown();
+        return benchOk ? 0 : -1;
+    }
+    
+    // Бенчмарк масштабирования загрузки IPL файлов из gta.dat: --bench-ipl-threads
+    if (hasCommandLineFlag(commandLineArgs, "--bench-ipl-threads")) {
+        bool benchOk = runIplScalingBenchmark(iplEntries);
+        renderer.Shutdown();
+        return benchOk ? 0 : -1;
+    }
+    
+    // Бенчмарк масштабирования разбора DFF моделей из IMG: --bench-dff-decode
+    if (hasCommandLineFlag(commandLineArgs, "--bench-dff-decode")) {
+        bool benchOk = runDffDecodeBenchmark(imgEntries);
+        renderer.Shutdown();
+        return benchOk ? 0 : -1;
+    }
+    
+    // Манифест сцены: если ни один входной файл не изменился, разбор IDE/IPL
+    // и сборка сцены пропускаются (ключ --no-scene-cache отключает кэш)
+    const std::string sceneManifestPath = "scene.manifest";
+    bool sceneCacheEnabled = !hasCommandLineFlag(commandLineArgs, "--no-scene-cache");
+    std::vector<SceneManifest::InputFile> sceneInputs;
+    sceneInputs.push_back(SceneManifest::DescribeInput("data\\gta.dat"));
+    for (const auto* entries : { &ideEntries, &iplEntries, &imgEntries }) {
+        for (const auto& entry : *entries) {
+            sceneInputs.push_back(SceneManifest::DescribeInput(entry.path));
+        }
+    }
+
+    // Переупаковке нужны объекты IPL, а не готовая сцена - для нее всегда холодный старт
+    SceneManifest sceneManifest;
+    bool warmStart = sceneCacheEnabled && !hasCommandLineFlag(commandLineArgs, "--repack-img") &&
+                     sceneManifest.Load(sceneManifestPath, sceneInputs);
+    if (warmStart) {
+        LogSystem("Манифест сцены актуален: " + std::to_string(sceneManifest.placements.size()) + " размещений, " +
+                  std::to_string(sceneManifest.definitions.size()) + " определений IDE");
+    }
+    else if (sceneCacheEnabled) {
+        LogSystem("Манифест сцены отсутствует или устарел - полная загрузка");
+    }
+
+    // Общий пул потоков загрузки (IDE, IPL, IMG, хэши содержимого)
+    ThreadPool loaderPool;
+
+    // Определения моделей из IDE: дальность прорисовки для отсечения и имена для бинарных IPL
+    auto ideLoadStart = std::chrono::high_resolution_clock::now();
+    ide::IdeData modelDefinitions = warmStart ? sceneManifest.BuildDefinitions() : loadIdeFiles(ideEntries, &loaderPool);
+    double ideLoadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - ideLoadStart).count();
+    LogModels("Загружено определений моделей " + std::string(warmStart ? "из манифеста: " : "из IDE: ") +
+              std::to_string(modelDefinitions.getDefinitionCount()) + " (" + std::to_string(ideLoadMs) + " мс)");
+    renderer.SetModelDefinitions(&modelDefinitions);
+
     // ============================================================================
     // ЭТАП 2: ПАРСИНГ IPL ФАЙЛОВ И СОБИРАНИЕ ОБЪЕКТОВ
     // ============================================================================
 
-    std::vector<ipl::IplObject> allObjects;
+    // IPL файлы разбираются параллельно, каждый в свой буфер; после открытия IMG к ним добавляются
+    // бинарные IPL, и буферы сливаются в порядке gta.dat - результат совпадает с последовательной
+    // загрузкой (ключ --serial-ipl)
+    bool serialIplLoading = hasCommandLineFlag(commandLineArgs, "--serial-ipl");
+    std::vector<IplLoadResult> iplResults;
+    if (!warmStart) {
+        auto iplLoadStart = std::chrono::high_resolution_clock::now();
+        iplResults = loadIplFiles(iplEntries, serialIplLoading ? nullptr : &loaderPool);
 
-    for (const auto& entry : iplEntries) {
-        ipl::IplData iplData;
-        if (ipl::loadIplFile(entry.path.c_str(), iplData)) {
-            const auto& objects = iplData.getAllObjects();
-            allObjects.insert(allObjects.end(), objects.begin(), objects.end());
-            LogIpl("IPL загружен: " + entry.path + " (объектов: " + std::to_string(objects.size()) + ")");
-        }
-        else {
-            LogIpl("ОШИБКА: Не удалось загрузить IPL файл: " + entry.path);
+        for (size_t i = 0; i < iplResults.size(); i++) {
+            if (iplResults[i].loaded) {
+                LogIpl("IPL загружен: " + iplEntries[i].path + " (объектов: " + std::to_string(iplResults[i].data.getObjectCount()) + ")");
+            }
+            else {
+                LogIpl("ОШИБКА: Не удалось загрузить IPL файл: " + iplEntries[i].path);
+            }
         }
+
+        double iplLoadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - iplLoadStart).count();
+        LogIpl("Загрузка IPL (" + (serialIplLoading ? std::string("последовательно") : std::to_string(loaderPool.GetThreadCount()) + " потоков") +
+               "): " + std::to_string(iplLoadMs) + " мс");
     }
-    
-    LogSystem("Всего собрано объектов из IPL: " + std::to_string(allObjects.size()));
-    
-    // Анализируем координаты объектов для отладки
-    if (!allObjects.empty()) {
-        float minX = allObjects[0].x, maxX = allObjects[0].x;
-        float minY = allObjects[0].y, maxY = allObjects[0].y;
-        float minZ = allObjects[0].z, maxZ = allObjects[0].z;
-        
-        for (const auto& obj : allObjects) {
-            minX = std::min(minX, obj.x);
-            maxX = std::max(maxX, obj.x);
-            minY = std::min(minY, obj.y);
-            maxY = std::max(maxY, obj.y);
-            minZ = std::min(minZ, obj.z);
-            maxZ = std::max(maxZ, obj.z);
-        }
-        
-        LogSystem("Диапазон координат объектов:");
-        LogSystem("  X: от " + std::to_string(minX) + " до " + std::to_string(maxX));
-        LogSystem("  Y: от " + std::to_string(minY) + " до " + std::to_string(maxY));
-        LogSystem("  Z: от " + std::to_string(minZ) + " до " + std::to_string(maxZ));
+
+    // Бюджет кэша разобранных моделей: --asset-cache-mb <мегабайты>
+    auto cacheArg = std::find(commandLineArgs.begin(), commandLineArgs.end(), "--asset-cache-mb");
+    if (cacheArg != commandLineArgs.end() && std::distance(cacheArg, commandLineArgs.end()) >= 2) {
+        size_t cacheMb = std::strtoull((cacheArg + 1)->c_str(), nullptr, 10);
+        AssetCache::Models().SetBudget(cacheMb * 1024 * 1024);
+        LogSystem("Бюджет кэша моделей: " + std::to_string(cacheMb) + " МБ");
     }
 
     // ============================================================================
@@ -319,151 +1442,257 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
     std::vector<img::ImgData*> loadedImgArchives;
 
-    for (const auto& entry : imgEntries) {
-        FILE* testFile = fopen(entry.path.c_str(), "rb");
-        if (!testFile) {
+    // Архивы открываются параллельно (каталог + отображение в память), ключ --serial-img
+    // оставляет последовательную загрузку для сравнения
+    bool serialImgLoading = hasCommandLineFlag(commandLineArgs, "--serial-img");
+    
+    auto imgLoadStart = std::chrono::high_resolution_clock::now();
+    std::vector<ImgOpenResult> imgResults = openImgArchives(imgEntries, serialImgLoading ? nullptr : &loaderPool);
+    double imgLoadWallMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - imgLoadStart).count();
+
+    // Сливаем результаты в порядке gta.dat / папки models
+    double imgLoadSumMs = 0.0;
+    double imgLoadMaxMs = 0.0;
+    for (size_t i = 0; i < imgResults.size(); i++) {
+        const auto& entry = imgEntries[i];
+        const auto& result = imgResults[i];
+        imgLoadSumMs += result.openMs;
+        imgLoadMaxMs = std::max(imgLoadMaxMs, result.openMs);
+        
+        if (!result.fileFound) {
             LogImg("ПРЕДУПРЕЖДЕНИЕ: Файл не найден: " + entry.path);
-            continue;
         }
-        fclose(testFile);
-
-        img::ImgData* imgData = new img::ImgData();
-        if (img::loadImgFile(entry.path.c_str(), *imgData)) {
-            loadedImgArchives.push_back(imgData);
-            LogImg("IMG архив загружен: " + entry.path + " (файлов: " + std::to_string(imgData->getFileCount()) + ")");
+        else if (result.imgData) {
+            loadedImgArchives.push_back(result.imgData);
+            LogImg("IMG архив загружен: " + entry.path + " (файлов: " + std::to_string(result.imgData->getFileCount()) + 
+                   ", " + std::to_string(result.openMs) + " мс)");
         }
         else {
             LogImg("ОШИБКА: Не удалось загрузить IMG архив: " + entry.path);
-            delete imgData;
         }
     }
     
     LogSystem("Всего загружено IMG архивов: " + std::to_string(loadedImgArchives.size()));
+    
+    // Отчет об ускорении: сумма времен архивов - это стоимость последовательного пути
+    if (serialImgLoading) {
+        LogImg("Загрузка IMG (последовательно): " + std::to_string(imgLoadWallMs) + " мс");
+    }
+    else if (imgLoadWallMs > 0.0) {
+        LogImg("Загрузка IMG (" + std::to_string(loaderPool.GetThreadCount()) + " потоков): " + std::to_string(imgLoadWallMs) + 
+               " мс, последовательно было бы ~" + std::to_string(imgLoadSumMs) + " мс, самый большой архив " + 
+               std::to_string(imgLoadMaxMs) + " мс, ускорение x" + std::to_string(imgLoadSumMs / imgLoadWallMs));
+    }
 
+    // Строим единый индекс имен по всем архивам (порядок архивов задает приоритет)
+    auto indexStart = std::chrono::high_resolution_clock::now();
+    img::AssetIndex assetIndex;
+    assetIndex.build(loadedImgArchives);
+    auto indexTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - indexStart);
+    LogImg("Индекс файлов IMG построен: " + std::to_string(assetIndex.size()) + " имен, затенено " + 
+           std::to_string(assetIndex.getShadowedCount()) + ", макс. проб " + std::to_string(assetIndex.getMaxProbe()) + 
+           " (" + std::to_string(indexTime.count()) + " мкс)");
+    
     // Передаем IMG архивы в Renderer для системы fallback
     renderer.SetImgArchives(loadedImgArchives);
+    renderer.SetAssetIndex(&assetIndex);
     
     // Проверяем наличие DFF файлов в IMG архивах
     int totalDffFiles = 0;
     for (const auto* imgData : loadedImgArchives) {
-        auto dffFiles = imgData->getFilesByExtension(".dff");
-        totalDffFiles += dffFiles.size();
+        totalDffFiles += imgData->getFileCountByExtension(".dff");
     }
     LogSystem("Всего DFF файлов в IMG архивах: " + std::to_string(totalDffFiles));
+    
+    // Коллизии сцены разбираются из отображенных архивов; разобранные наборы живут в кэше коллизий
+    std::vector<std::shared_ptr<const std::vector<CollisionModel>>> sceneCollisions;
+    size_t collisionModelCount = 0;
+    for (size_t archiveIndex = 0; archiveIndex < loadedImgArchives.size(); archiveIndex++) {
+        collisionModelCount += loadColModelsFromImg(assetIndex, *loadedImgArchives[archiveIndex], static_cast<uint32_t>(archiveIndex), sceneCollisions);
+    }
+    LogCol("Загружено моделей коллизий: " + std::to_string(collisionModelCount) + " из " + 
+           std::to_string(sceneCollisions.size()) + " .col файлов");
 
-    // ============================================================================
-    // ЭТАП 4: ЗАГРУЗКА МОДЕЛЕЙ В СЦЕНУ (С ПРЕДОТВРАЩЕНИЕМ ДУБЛИКАТОВ)
-    // ============================================================================
-
-    int successCount = 0;
-    int fallbackCount = 0;
-    int debugCount = 0;
-    int duplicateCount = 0;
-
-    // Группируем объекты по координатам для предотвращения дубликатов
-    LogSystem("Группировка объектов по координатам для предотвращения дубликатов...");
-    std::vector<ObjectGroup> objectGroups = groupObjectsByCoordinates(allObjects, 1.0f);
-    LogSystem("Создано групп объектов: " + std::to_string(objectGroups.size()) + " из " + std::to_string(allObjects.size()) + " объектов");
+    // Сцена: из манифеста при теплом старте, иначе полная сборка из IPL
+    std::vector<SceneManifest::ResolvedPlacement> scenePlacements;
+    SceneManifest::SceneStats sceneStats;
+    std::chrono::high_resolution_clock::duration modelResolveTime{};
 
-    // Обрабатываем каждую группу объектов
-    for (size_t groupIndex = 0; groupIndex < objectGroups.size(); groupIndex++) {
-        const auto& group = objectGroups[groupIndex];
+    if (warmStart) {
+        scenePlacements = std::move(sceneManifest.placements);
+        sceneStats = sceneManifest.stats;
         
-        if (debugCount < 10) {
-            LogModels("Группа #" + std::to_string(groupIndex) + ": " + std::to_string(group.objectIndices.size()) + 
-                     " объектов в позиции (" + std::to_string(group.x) + ", " + std::to_string(group.y) + ", " + std::to_string(group.z) + ")");
-            
-            // Показываем детали группы для отладки
-            if (group.objectIndices.size() > 1) {
-                LogModels("  Объекты в группе:");
-                for (size_t objIdx : group.objectIndices) {
-                    const auto& obj = allObjects[objIdx];
-                    LogModels("    - " + obj.name + " (ID: " + std::to_string(obj.modelId) + ")");
-                    
-                    // Проверяем, есть ли LOD версия для этого объекта
-                    std::string lodCheck = "lod" + obj.name + ".dff";
-                    if (img::modelExists(loadedImgArchives, lodCheck)) {
-                        LogModels("      -> LOD версия найдена: " + lodCheck);
-                    }
-                }
+        // Манифест хранит имена моделей - записи индекса находятся один раз здесь
+        for (auto& resolved : scenePlacements) {
+            if (!resolved.modelName.empty()) {
+                resolved.modelEntry = assetIndex.find(resolved.modelName);
             }
-            debugCount++;
+        }
+        LogSystem("Сцена из манифеста: " + std::to_string(sceneStats.objectCount) + " объектов, " +
+                  std::to_string(sceneStats.groupCount) + " групп");
+    }
+    else {
+        // Потоковые бинарные IPL лежат в IMG архивах - подключаем их после открытия архивов
+        auto streamedIplStart = std::chrono::high_resolution_clock::now();
+        StreamedIplStats streamedIplStats = attachStreamedIpls(assetIndex, modelDefinitions, iplEntries, iplResults, serialIplLoading ? nullptr : &loaderPool);
+        double streamedIplMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - streamedIplStart).count();
+        LogIpl("Бинарные IPL из IMG: " + std::to_string(streamedIplStats.files) + " файлов, " +
+               std::to_string(streamedIplStats.objects) + " объектов (" + std::to_string(streamedIplMs) + " мс)");
+        if (streamedIplStats.unnamed > 0) {
+            LogIpl("ПРЕДУПРЕЖДЕНИЕ: " + std::to_string(streamedIplStats.unnamed) +
+                   " объектов бинарных IPL пропущено - ID модели нет ни в IDE, ни в текстовых IPL");
         }
 
-        // Выбираем лучшую модель для этой группы
-        std::string bestModelName = selectBestModelForGroup(loadedImgArchives, allObjects, group);
-        bool modelFound = false;
+        std::vector<ipl::IplObject> allObjects = mergeIplResults(iplResults);
+        LogSystem("Всего собрано объектов из IPL: " + std::to_string(allObjects.size()));
 
-        // Сначала ищем в IMG архивах
-        if (!bestModelName.empty()) {
-            if (debugCount <= 10) {
-                LogModels("Найдена лучшая DFF модель для группы: " + bestModelName);
-            }
-            
-            std::vector<uint8_t> modelData = img::getModelData(loadedImgArchives, bestModelName);
-
-            dff::DffData dffData;
-            if (dffData.loadDffFromBuffer(modelData, bestModelName)) {
-                const dff::DffModel& model = dffData.getModel();
-                // Используем координаты группы (первого объекта)
-                const auto& firstObj = allObjects[group.objectIndices[0]];
-                renderer.AddDffModel(model, firstObj.name.c_str(), group.x, group.y, group.z, 
-                                   firstObj.rx, firstObj.ry, firstObj.rz, firstObj.rw);
-                modelFound = true;
-                successCount++;
-                
-                if (debugCount <= 10) {
-                    LogSuccess("DFF модель загружена для группы: " + firstObj.name + " (версия: " + bestModelName + ")");
-                }
+        // Дальше сцена работает с таблицей экземпляров: колонки координат и общие имена моделей
+        SceneInstanceTable sceneInstances;
+        sceneInstances.AddIplObjects(allObjects);
+        sceneStats.objectCount = sceneInstances.Size();
+        sceneStats.modelNameCount = sceneInstances.GetModelCount();
+        LogSystem("Таблица экземпляров: " + std::to_string(sceneInstances.Size()) + " объектов, " +
+                  std::to_string(sceneInstances.GetModelCount()) + " уникальных имен моделей");
+
+        // Границы сцены
+        if (sceneInstances.Size() > 0) {
+            const std::vector<float>& objectX = sceneInstances.GetX();
+            const std::vector<float>& objectY = sceneInstances.GetY();
+            const std::vector<float>& objectZ = sceneInstances.GetZ();
+            sceneStats.minX = *std::min_element(objectX.begin(), objectX.end());
+            sceneStats.maxX = *std::max_element(objectX.begin(), objectX.end());
+            sceneStats.minY = *std::min_element(objectY.begin(), objectY.end());
+            sceneStats.maxY = *std::max_element(objectY.begin(), objectY.end());
+            sceneStats.minZ = *std::min_element(objectZ.begin(), objectZ.end());
+            sceneStats.maxZ = *std::max_element(objectZ.begin(), objectZ.end());
+        }
+
+        // Инструмент переупаковки: --repack-img <исходный.img> <результат.img>
+        auto repackArg = std::find(commandLineArgs.begin(), commandLineArgs.end(), "--repack-img");
+        if (repackArg != commandLineArgs.end()) {
+            bool repackOk = false;
+            if (std::distance(repackArg, commandLineArgs.end()) >= 3) {
+                repackOk = runImgRepackTool(*(repackArg + 1), *(repackArg + 2), allObjects);
             }
             else {
-                LogModels("ОШИБКА: Не удалось загрузить DFF модель: " + bestModelName);
+                LogError("Использование: --repack-img <исходный.img> <результат.img>");
             }
-        } else if (debugCount <= 10) {
-            LogModels("DFF модель не найдена в IMG для группы в позиции (" + 
-                     std::to_string(group.x) + ", " + std::to_string(group.y) + ", " + std::to_string(group.z) + ")");
+            renderer.Shutdown();
+            return repackOk ? 0 : -1;
         }
 
-        // Fallback: ищем в папке unpack
-        if (!modelFound) {
-            const auto& firstObj = allObjects[group.objectIndices[0]];
-            std::string unpackPath = findBestModelInUnpack(firstObj.name);
-            
-            if (!unpackPath.empty()) {
-                dff::DffData dffData;
-
-                if (dffData.loadDffFile(unpackPath.c_str())) {
-                    const dff::DffModel& model = dffData.getModel();
-                    renderer.AddDffModel(model, firstObj.name.c_str(), group.x, group.y, group.z, 
-                                       firstObj.rx, firstObj.ry, firstObj.rz, firstObj.rw);
-                    modelFound = true;
-                    successCount++;
-                    
-                    if (debugCount <= 10) {
-                        LogSuccess("DFF модель загружена из unpack для группы: " + firstObj.name + " (путь: " + unpackPath + ")");
-                    }
-                }
+        // Список IplObject больше не нужен - все данные в таблице экземпляров
+        allObjects.clear();
+        allObjects.shrink_to_fit();
+        iplResults.clear();
+
+        // Группы, связи LOD и выбор моделей
+        auto resolveStart = std::chrono::high_resolution_clock::now();
+        resolveScenePlacements(assetIndex, modelDefinitions, sceneInstances, scenePlacements, sceneStats, &loaderPool);
+        modelResolveTime = std::chrono::high_resolution_clock::now() - resolveStart;
+
+        // Сохраняем результат для следующего запуска
+        if (sceneCacheEnabled && !scenePlacements.empty()) {
+            sceneManifest.inputs = sceneInputs;
+            sceneManifest.definitions.clear();
+            sceneManifest.definitions.reserve(modelDefinitions.getDefinitionCount());
+            for (const auto& [modelId, definition] : modelDefinitions.getAllDefinitions()) {
+                sceneManifest.definitions.push_back(definition);
             }
+            sceneManifest.placements = scenePlacements;
+            sceneManifest.stats = sceneStats;
+            if (sceneManifest.Save(sceneManifestPath)) {
+                LogSystem("Манифест сцены записан: " + sceneManifestPath);
+            }
+            sceneManifest.placements.clear();
+            sceneManifest.placements.shrink_to_fit();
         }
+    }
 
-        // Если модель не найдена, используем куб как fallback
-        if (!modelFound) {
-            fallbackCount++;
-            const auto& firstObj = allObjects[group.objectIndices[0]];
-            renderer.AddTestObject(groupIndex + 1, firstObj.modelId, firstObj.name.c_str(), 
-                                 group.x, group.y, group.z, firstObj.rx, firstObj.ry, firstObj.rz, firstObj.rw);
-            
-            if (debugCount <= 10) {
-                LogWarning("Создан fallback куб для группы в позиции (" + 
-                          std::to_string(group.x) + ", " + std::to_string(group.y) + ", " + std::to_string(group.z) + ")");
+    // Анализируем координаты объектов для отладки
+    if (sceneStats.objectCount > 0) {
+        LogSystem("Диапазон координат объектов:");
+        LogSystem("  X: от " + std::to_string(sceneStats.minX) + " до " + std::to_string(sceneStats.maxX));
+        LogSystem("  Y: от " + std::to_string(sceneStats.minY) + " до " + std::to_string(sceneStats.maxY));
+        LogSystem("  Z: от " + std::to_string(sceneStats.minZ) + " до " + std::to_string(sceneStats.maxZ));
+    }
+
+    // ============================================================================
+    // ЭТАП 4: ЗАГРУЗКА МОДЕЛЕЙ В СЦЕНУ (С ПРЕДОТВРАЩЕНИЕМ ДУБЛИКАТОВ)
+    // ============================================================================
+
+    int successCount = 0;
+    int fallbackCount = 0;
+
+    // Модели из IMG читаются и разбираются в фоне (ближние к камере - первыми),
+    // основной поток сразу переходит к рендеру
+    ModelStreamer modelStreamer;
+    int streamedGroupCount = 0;
+
+    // Размещения без модели в IMG берут DFF из папки unpack: уникальные файлы собираются заранее
+    // и разбираются пулом, затем модели раздаются размещениям в порядке сцены
+    auto fallbackDecodeStart = std::chrono::high_resolution_clock::now();
+    std::vector<std::string> unpackPaths;
+    std::vector<size_t> placementUnpackSlots(scenePlacements.size(), SIZE_MAX);
+    {
+        std::unordered_map<std::string, size_t> unpackSlots;
+        for (size_t i = 0; i < scenePlacements.size(); i++) {
+            if (scenePlacements[i].modelEntry) {
+                continue;
+            }
+            std::string unpackPath = findUnpackModel(scenePlacements[i].placement);
+            if (unpackPath.empty()) {
+                continue;
             }
+            auto slot = unpackSlots.emplace(unpackPath, unpackPaths.size());
+            if (slot.second) {
+                unpackPaths.push_back(unpackPath);
+            }
+            placementUnpackSlots[i] = slot.first->second;
         }
+    }
+    std::vector<std::shared_ptr<const dff::DffModel>> unpackModels = decodeDffFiles(unpackPaths, &loaderPool);
+    double fallbackDecodeMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - fallbackDecodeStart).count();
+    LogModels("Разобрано DFF из unpack: " + std::to_string(unpackPaths.size()) + " уникальных моделей (" +
+              std::to_string(loaderPool.GetThreadCount()) + " потоков): " + std::to_string(fallbackDecodeMs) + " мс");
 
-        // Подсчитываем дубликаты
-        if (group.objectIndices.size() > 1) {
-            duplicateCount += group.objectIndices.size() - 1;
+    for (size_t i = 0; i < scenePlacements.size(); i++) {
+        const auto& resolved = scenePlacements[i];
+        const bool verbose = i < 10;
+
+        // Лучшая модель для этой группы уже выбрана - отдаем ее стримеру
+        if (resolved.modelEntry) {
+            if (verbose) {
+                LogModels("Найдена лучшая DFF модель для группы: " + resolved.modelName);
+            }
+            modelStreamer.AddPlacement(resolved.modelName, *resolved.modelEntry, resolved.placement);
+            streamedGroupCount++;
+        }
+        else {
+            if (verbose) {
+                LogModels("DFF модель не найдена в IMG для группы в позиции (" + std::to_string(resolved.placement.x) + ", " +
+                          std::to_string(resolved.placement.y) + ", " + std::to_string(resolved.placement.z) + ")");
+            }
+
+            // Fallback: разобранная модель из unpack, затем куб
+            const size_t slot = placementUnpackSlots[i];
+            const bool hasUnpack = slot != SIZE_MAX;
+            if (addFallbackModel(renderer, resolved.placement, hasUnpack ? unpackPaths[slot] : std::string(),
+                                 hasUnpack ? unpackModels[slot] : nullptr, verbose)) {
+                successCount++;
+            }
+            else {
+                fallbackCount++;
+            }
         }
     }
+    unpackModels.clear();
+    scenePlacements.clear();
+    scenePlacements.shrink_to_fit();
+    
+    modelStreamer.Start(&assetIndex);
+    LogModels("Стриминг запущен: " + std::to_string(modelStreamer.GetModelCount()) + " моделей для " + 
+              std::to_string(streamedGroupCount) + " групп");
 
     // ============================================================================
     // ЭТАП 5: ФИНАЛЬНАЯ СТАТИСТИКА
@@ -484,37 +1713,90 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
     LogSystem("========================================");
     LogSystem("СТАТИСТИКА ЗАГРУЗКИ МОДЕЛЕЙ:");
     LogSystem("========================================");
-    LogSystem("Всего объектов в IPL: " + std::to_string(allObjects.size()));
-    LogSystem("Создано групп объектов: " + std::to_string(objectGroups.size()));
-    LogSystem("Предотвращено дубликатов: " + std::to_string(duplicateCount));
-    LogSystem("Загружено DFF моделей: " + std::to_string(successCount));
+    LogSystem("Всего объектов в IPL: " + std::to_string(sceneStats.objectCount));
+    LogSystem("Создано групп объектов: " + std::to_string(sceneStats.groupCount));
+    LogSystem("Предотвращено дубликатов: " + std::to_string(sceneStats.duplicateCount));
+    LogSystem("Загружено DFF моделей из unpack: " + std::to_string(successCount));
+    LogSystem("Поставлено в стриминг: " + std::to_string(modelStreamer.GetModelCount()) + " DFF моделей (" + 
+              std::to_string(streamedGroupCount) + " групп)");
     LogSystem("Создано fallback кубов: " + std::to_string(fallbackCount));
+    if (!warmStart) {
+        LogSystem("Время сборки сцены (группы, LOD, выбор моделей): " +
+                  std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(modelResolveTime).count()) + " мс");
+    }
+    LogSystem("Загрузка до первого кадра (" + std::string(warmStart ? "теплый старт из манифеста" : "холодный старт") + "): " +
+              std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - sceneLoadStart).count()) + " мс");
+    
+    // Архивы отображены в память - копии создаются только для кода, которому нужен владеющий буфер
+    size_t loadedImgFiles = 0;
+    for (const auto* imgData : loadedImgArchives) {
+        loadedImgFiles += imgData->getLoadedFileCount();
+    }
+    LogSystem("Скопировано файлов из IMG в память: " + std::to_string(loadedImgFiles) + " из " + std::to_string(totalDffFiles) + " DFF в архивах");
+    LogSystem("Кэш ассетов: " + AssetCache::GetStatsString());
+    LogSystem("Папка unpack: " + std::to_string(AssetCache::Unpack().GetFileCount()) + " DFF файлов, без рабочей модели " +
+              std::to_string(AssetCache::Unpack().GetMissingCount()) + " имен");
     LogSystem("========================================");
 
 
 
     // Проверяем, есть ли объекты в сцене
-    if (successCount == 0 && fallbackCount == 0) {
+    if (successCount == 0 && fallbackCount == 0 && streamedGroupCount == 0) {
         LogError("КРИТИЧЕСКАЯ ОШИБКА: В сцену не загружено ни одной модели!");
         LogError("Проверьте: 1) IPL файлы загружаются корректно 2) DFF модели существуют в IMG архивах");
     }
 
-    // Очищаем память
-    renderer.ClearImgArchives(); // Очищаем ссылки в Renderer
-    for (auto* imgData : loadedImgArchives) {
-        delete imgData;
-    }
-    loadedImgArchives.clear();
-
-
+    std::vector<ModelStreamer::StreamedModel> streamedModels;
+    bool streamingReported = false;
+    auto streamingStart = std::chrono::high_resolution_clock::now();
 
     while (!renderer.ShouldClose()) {
         renderer.BeginFrame();
+        
+        // Стример получает позицию камеры, готовые модели уходят в Renderer (GPU - в Render)
+        modelStreamer.UpdateCamera(renderer.GetCameraX(), renderer.GetCameraY(), renderer.GetRenderRadius());
+        streamedModels.clear();
+        modelStreamer.CollectFinished(streamedModels, 64);
+        for (const auto& streamed : streamedModels) {
+            for (const auto& placement : streamed.placements) {
+                if (streamed.success) {
+                    renderer.AddDffModel(streamed.assetKey, streamed.model, placement.objectName.c_str(), placement.x, placement.y, placement.z,
+                                         placement.rx, placement.ry, placement.rz, placement.rw, placement.groupIndex, placement.lodGroupIndex);
+                }
+                else {
+                    LogModels("ОШИБКА: Не удалось загрузить DFF модель: " + streamed.modelName);
+                    addFallbackModel(renderer, placement, false);
+                }
+            }
+        }
+        
+        if (!streamingReported && modelStreamer.IsIdle()) {
+            auto streamingTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - streamingStart);
+            LogModels("Стриминг в радиусе завершен за " + std::to_string(streamingTime.count()) + " мс: загружено " + 
+                      std::to_string(modelStreamer.GetCompletedCount()) + ", ошибок " + std::to_string(modelStreamer.GetFailedCount()) + 
+                      ", отменено " + std::to_string(modelStreamer.GetCancelledCount()));
+            LogModels("Кэш ассетов: " + AssetCache::GetStatsString());
+            LogModels("Дубликаты по содержимому: " + std::to_string(assetIndex.getDedupCount()) + " записей, " +
+                      std::to_string(assetIndex.getDedupBytes() / 1024) + " КБ без повторного разбора");
+            streamingReported = true;
+        }
+        
         renderer.Render();
         renderer.EndFrame();
         //std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
     
+    // Потоки стриминга читают архивы - останавливаем их до освобождения памяти
+    modelStreamer.Stop();
+    renderer.ClearImgArchives(); // Очищаем ссылки в Renderer
+    assetIndex.clear();
+    AssetCache::Models().Clear();
+    AssetCache::Collisions().Clear();
+    for (auto* imgData : loadedImgArchives) {
+        delete imgData;
+    }
+    loadedImgArchives.clear();
+    
     renderer.Shutdown();
     return 0;
 }